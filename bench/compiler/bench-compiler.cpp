@@ -0,0 +1,142 @@
+// Runs each phase of the compiler in-process on a single input file, and prints the time and peak memory usage after
+// each phase as a JSON object. Only one input is compiled per process, because imported modules such as std are cached
+// globally. Used by bench/compiler/run.py, see there for how to run the benchmarks.
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#pragma warning(push, 0)
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#pragma warning(pop)
+#include "ast/module.h"
+#include "backend/c-backend.h"
+#include "backend/function-folding.h"
+#include "backend/irgen.h"
+#include "backend/llvm.h"
+#include "driver/driver.h"
+#include "parser/parse.h"
+#include "sema/null-analyzer.h"
+#include "sema/typecheck.h"
+
+namespace cx {
+extern int errors;
+}
+
+using namespace cx;
+
+/// Returns the peak resident set size of the process so far in kilobytes, or 0 if it's not available.
+static long getPeakMemoryUsage() {
+#ifdef _WIN32
+    return 0; // TODO
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+struct PhaseResult {
+    const char* name;
+    double milliseconds;
+    long peakMemoryKilobytes;
+};
+
+int main(int argc, const char** argv) {
+    if (argc != 2) {
+        llvm::errs() << "usage: " << argv[0] << " <input.cx>\n";
+        return 2;
+    }
+
+    CompileOptions options;
+    options.noUnusedWarnings = true;
+    options.importSearchPaths = {CX_ROOT_DIR, CLANG_BUILTIN_INCLUDE_PATH, "/usr/include", "/usr/local/include"};
+#ifdef _WIN32
+    options.defines.push_back("Windows");
+#endif
+#ifdef __APPLE__
+    options.defines.push_back("macOS");
+#endif
+
+    std::vector<PhaseResult> results;
+    auto measure = [&](const char* name, auto&& phase) {
+        auto start = std::chrono::steady_clock::now();
+        phase();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        results.push_back({name, elapsed.count(), getPeakMemoryUsage()});
+        if (errors) {
+            llvm::errs() << "errors in phase '" << name << "'\n";
+            exit(1);
+        }
+    };
+
+    Module mainModule("main");
+    addFileBufferToModule(argv[1], mainModule);
+
+    measure("parse", [&] {
+        Parser parser(*mainModule.fileBuffers.front(), mainModule, options);
+        parser.parse();
+    });
+
+    // Includes parsing and typechecking std and imported C headers, which happens when they're first imported.
+    measure("typecheck", [&] {
+        Typechecker typechecker(options);
+        for (auto& importedModule : mainModule.getImportedModules()) {
+            typechecker.typecheckModule(*importedModule, nullptr);
+        }
+        typechecker.typecheckModule(mainModule, nullptr);
+    });
+
+    IRGenerator irGenerator;
+    measure("irgen", [&] {
+        for (auto* importedModule : Module::getAllImportedModules()) {
+            irGenerator.emitModule(*importedModule);
+        }
+        irGenerator.emitModule(mainModule);
+    });
+
+    measure("null-analysis", [&] {
+        NullAnalyzer nullAnalyzer;
+        for (auto* module : irGenerator.generatedModules) {
+            nullAnalyzer.analyze(module);
+        }
+    });
+
+    measure("function-folding", [&] {
+        FunctionFolder functionFolder;
+        functionFolder.fold(irGenerator.generatedModules);
+    });
+
+    measure("llvm-backend", [&] {
+        LLVMGenerator llvmGenerator;
+        for (auto* irModule : irGenerator.generatedModules) {
+            llvmGenerator.codegenModule(*irModule);
+        }
+    });
+
+    measure("c-backend", [&] {
+        CGenerator cGenerator;
+        for (auto* irModule : irGenerator.generatedModules) {
+            cGenerator.codegenModule(*irModule);
+        }
+        cGenerator.finish();
+    });
+
+    llvm::outs() << "{";
+    for (auto& result : results) {
+        if (&result != &results.front()) llvm::outs() << ", ";
+        llvm::outs() << "\"" << result.name << "\": {\"time\": " << llvm::format("%.3f", result.milliseconds)
+                     << ", \"peakMemory\": " << result.peakMemoryKilobytes << "}";
+    }
+    llvm::outs() << "}\n";
+    return 0;
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+# Compares two result files written by bench/compiler/run.py, and exits with a nonzero status if any phase got slower
+# or used more memory than the threshold allows. Run with:
+#
+#   bench/compiler/compare.py baseline.json results.json --threshold 10
+
+import argparse
+import json
+import sys
+
+arg_parser = argparse.ArgumentParser()
+arg_parser.add_argument("baseline", help="results of the baseline compiler")
+arg_parser.add_argument("current", help="results of the compiler to check for regressions")
+arg_parser.add_argument("--threshold", help="percentage increase that counts as a regression", type=float, default=10)
+arg_parser.add_argument("--min-time", help="ignore time changes in phases faster than this many milliseconds", type=float, default=5)
+args = arg_parser.parse_args()
+
+with open(args.baseline) as file:
+    baseline = json.load(file)
+with open(args.current) as file:
+    current = json.load(file)
+
+if baseline.get("scale") != current.get("scale"):
+    print(f"warning: comparing results of different input scales ({baseline.get('scale')} and {current.get('scale')})", file=sys.stderr)
+
+
+def percent_change(old, new):
+    return (new - old) / old * 100 if old > 0 else 0
+
+
+regressions = []
+print(f"{'input':<24} {'phase':<18} {'time (ms)':>22} {'peak memory (KB)':>26}")
+
+for input_name, phases in sorted(current["inputs"].items()):
+    if input_name not in baseline["inputs"]:
+        continue
+
+    for phase, result in phases.items():
+        old = baseline["inputs"][input_name].get(phase)
+        if old is None:
+            continue
+
+        time_change = percent_change(old["time"], result["time"])
+        memory_change = percent_change(old["peakMemory"], result["peakMemory"])
+        flags = []
+        if time_change > args.threshold and max(old["time"], result["time"]) >= args.min_time:
+            flags.append("time")
+        if memory_change > args.threshold:
+            flags.append("memory")
+        if flags:
+            regressions.append(f"{input_name} {phase}: " + ", ".join(flags))
+
+        print(f"{input_name:<24} {phase:<18} {old['time']:>9.1f} -> {result['time']:>9.1f} {time_change:+6.1f}% "
+              f"{old['peakMemory']:>9} -> {result['peakMemory']:>9} {memory_change:+6.1f}%{'  REGRESSION' if flags else ''}")
+
+if regressions:
+    print(f"\n{len(regressions)} regression(s) above {args.threshold}%:")
+    for regression in regressions:
+        print(f"  {regression}")
+    sys.exit(1)
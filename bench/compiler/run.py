@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+
+# Measures the time and peak memory usage of each compiler phase on generated stress inputs, and writes the results as
+# JSON for comparison with bench/compiler/compare.py. Run with `cmake --build build --target bench_compiler`, or:
+#
+#   bench/compiler/run.py --harness path/to/bench_compiler_harness --output results.json
+#   bench/compiler/compare.py baseline.json results.json
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+
+def many_small_functions(scale):
+    lines = []
+    for i in range(2000 * scale):
+        lines.append(f"int function{i}(int a, int b) {{")
+        lines.append(f"    var sum = a + b * {i % 7};")
+        lines.append(f"    return function{i - 1}(b, sum);" if i > 0 else "    return sum;")
+        lines.append("}")
+    lines.append("void main() {")
+    lines.append(f"    println(function{2000 * scale - 1}(1, 2));")
+    lines.append("}")
+    return "\n".join(lines)
+
+
+def deep_generics(scale):
+    depth = 30 * scale
+    lines = ["struct Node<T>: Copyable {", "    T value;", "    int tag;", "}"]
+    for level in range(depth):
+        lines.append(f"int depth{level}<T>(T value) {{")
+        lines.append(f"    var list = List<T>();")
+        lines.append(f"    list.push(value);")
+        lines.append(f"    return depth{level + 1}(Node<T>(value, {level})) + list.size();")
+        lines.append("}")
+    lines.append(f"int depth{depth}<T>(T value) {{ return 0; }}")
+    lines.append("void main() {")
+    for root in ["42", "1.5", "true", "'c'"]:
+        lines.append(f"    println(depth0({root}));")
+    lines.append("}")
+    return "\n".join(lines)
+
+
+def huge_functions(scale):
+    lines = []
+    for function in range(4):
+        lines.append(f"int huge{function}(int seed) {{")
+        lines.append("    var total = seed;")
+        for i in range(5000 * scale):
+            lines.append(f"    var x{i} = total * {i % 13} + {i};")
+            lines.append(f"    if (x{i} % 3 == 0) {{ total += x{i}; }} else {{ total -= {i % 5}; }}")
+        lines.append("    return total;")
+        lines.append("}")
+    lines.append("void main() {")
+    for function in range(4):
+        lines.append(f"    println(huge{function}({function}));")
+    lines.append("}")
+    return "\n".join(lines)
+
+
+def many_c_header_imports(scale):
+    headers = ["assert.h", "ctype.h", "errno.h", "float.h", "inttypes.h", "limits.h", "locale.h", "math.h", "setjmp.h", "signal.h",
+               "stdarg.h", "stddef.h", "stdint.h", "stdio.h", "stdlib.h", "string.h", "time.h", "wchar.h", "wctype.h"]
+    lines = [f'import "{header}";' for header in headers]
+    lines.append("void main() {")
+    for i in range(100 * scale):
+        lines.append(f'    printf("%d %d\\n", abs(-{i}), isdigit({48 + i % 10}));')
+        lines.append(f'    println(strlen("{"x" * (i % 20 + 1)}"), " ", toupper({97 + i % 26}));')
+    lines.append("}")
+    return "\n".join(lines)
+
+
+def std_heavy_program(scale):
+    element_types = ["int", "int64", "uint8", "bool", "char", "string"]
+    values = {"int": "i", "int64": "int64(i)", "uint8": "uint8(i % 256)", "bool": "i % 2 == 0", "char": "'a'", "string": '"text"'}
+    lines = []
+    for index, type in enumerate(element_types):
+        value = values[type]
+        lines.append(f"int exercise{index}(int count) {{")
+        lines.append(f"    var list = List<{type}>();")
+        lines.append(f"    var queue = Queue<{type}>();")
+        lines.append(f"    var deque = Deque<{type}>();")
+        lines.append(f"    var set = Set<{type}>();")
+        lines.append(f"    var map = Map<int, {type}>();")
+        lines.append(f"    var orderedMap = OrderedMap<int, {type}>();")
+        lines.append("    var buffer = StringBuffer();")
+        lines.append("    for (var i in 0..count) {")
+        lines.append(f"        list.push({value});")
+        lines.append(f"        queue.push({value});")
+        lines.append(f"        deque.pushBack({value});")
+        lines.append(f"        set.insert({value});")
+        lines.append(f"        map.insert(i, {value});")
+        lines.append(f"        orderedMap.insert(i, {value});")
+        lines.append(f"        buffer.write(\"{type}\");")
+        lines.append("    }")
+        lines.append("    var total = list.size() + set.size() + map.size() + orderedMap.size() + buffer.size();")
+        lines.append("    while (!queue.empty()) { queue.pop(); total++; }")
+        lines.append("    for (var element in list) { if (set.contains(element)) total++; }")
+        lines.append("    return total + deque.size();")
+        lines.append("}")
+    for copy in range(10 * scale):
+        lines.append(f"int sortAndSum{copy}(List<int>* values) {{")
+        lines.append("    sort(values);")
+        lines.append("    var total = 0;")
+        lines.append(f"    for (var value in values) {{ total += *value + {copy}; }}")
+        lines.append("    return total;")
+        lines.append("}")
+    lines.append("void main() {")
+    lines.append("    var values = List([5, 3, 8, 1]);")
+    for index in range(len(element_types)):
+        lines.append(f"    println(exercise{index}(10));")
+    for copy in range(10 * scale):
+        lines.append(f"    println(sortAndSum{copy}(&values));")
+    lines.append("}")
+    return "\n".join(lines)
+
+
+inputs = {
+    "many-small-functions": many_small_functions,
+    "deep-generics": deep_generics,
+    "huge-functions": huge_functions,
+    "many-c-header-imports": many_c_header_imports,
+    "std-heavy-program": std_heavy_program,
+}
+
+arg_parser = argparse.ArgumentParser()
+arg_parser.add_argument("--harness", help="path to the bench_compiler_harness executable", required=True)
+arg_parser.add_argument("--output", help="path of the JSON file to write the results to", default="bench-compiler.json")
+arg_parser.add_argument("--runs", help="number of times to compile each input; the median time is reported", type=int, default=5)
+arg_parser.add_argument("--scale", help="multiplier for the size of the generated inputs", type=int, default=1)
+arg_parser.add_argument("--inputs-dir", help="directory to write the generated inputs to, instead of a temporary directory")
+arg_parser.add_argument("--only", help="comma-separated names of the inputs to run", default=",".join(inputs))
+args = arg_parser.parse_args()
+
+results = {}
+
+with tempfile.TemporaryDirectory() as temp_directory:
+    directory = args.inputs_dir or temp_directory
+    os.makedirs(directory, exist_ok=True)
+
+    for name in args.only.split(","):
+        source_path = os.path.join(directory, name + ".cx")
+        with open(source_path, "w") as source:
+            source.write(inputs[name](args.scale) + "\n")
+
+        runs = []
+        for _ in range(args.runs):
+            process = subprocess.run([args.harness, source_path], stdout=subprocess.PIPE, text=True)
+            if process.returncode != 0:
+                print(f"{name}: harness exited with status {process.returncode}", file=sys.stderr)
+                sys.exit(1)
+            runs.append(json.loads(process.stdout))
+
+        results[name] = {
+            phase: {
+                "time": round(statistics.median(run[phase]["time"] for run in runs), 3),
+                "peakMemory": max(run[phase]["peakMemory"] for run in runs),
+            }
+            for phase in runs[0]
+        }
+        print(f"{name}: " + ", ".join(f"{phase} {result['time']:.1f} ms" for phase, result in results[name].items()))
+
+with open(args.output, "w") as output:
+    json.dump({"version": 1, "runs": args.runs, "scale": args.scale, "inputs": results}, output, indent=2, sort_keys=True)
+    output.write("\n")
+
+print(f"Results written to {args.output}")
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+
+# Stress test for IR generation: compiles a generated function with 50K statements, each declaring locals and creating
+# temporaries, so that the function gets tens of thousands of allocas and nested scopes. The typecheck-only time is
+# measured as a baseline to subtract from the compile time. Run with:
+#
+#   bench/irgen-large-function.py --cx path/to/cx
+#   bench/irgen-large-function.py --cx path/to/cx -backend=c
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+arg_parser = argparse.ArgumentParser()
+arg_parser.add_argument("--cx", help="path to cx compiler executable", default="cx")
+arg_parser.add_argument("--statements", help="number of statements to generate", type=int, default=50000)
+arg_parser.add_argument("--runs", help="number of times to compile the file", type=int, default=3)
+args, cx_args = arg_parser.parse_known_args()
+
+lines = ["struct Pair { int a; int b; }", "", "int main() {", "    var sum = 0;"]
+statement_templates = [
+    "    var a{0} = {0} % 7;",
+    "    sum += a{1} * 3;",
+    "    if (sum > {0}) {{ var t{0} = Pair(sum, {0}); sum -= t{0}.b; }}",
+    '    var s{0} = "text"; sum += s{0}.size();',
+    "    for (var i{0} in 0..2) {{ sum += i{0}; }}",
+]
+for index in range(args.statements):
+    template = statement_templates[index % len(statement_templates)]
+    lines.append(template.format(index, index - index % len(statement_templates)))
+lines += ["    return sum % 256;", "}"]
+
+
+def measure(flags, source_path, object_path):
+    timings = []
+    for _ in range(args.runs):
+        start = time.perf_counter()
+        exit_status = subprocess.call([args.cx, *flags, *cx_args, source_path, "-o", object_path])
+        timings.append(time.perf_counter() - start)
+        if exit_status != 0:
+            sys.exit(exit_status)
+    return min(timings)
+
+
+with tempfile.TemporaryDirectory() as directory:
+    source_path = os.path.join(directory, "large-function.cx")
+    object_path = os.path.join(directory, "large-function.o")
+    with open(source_path, "w") as source:
+        source.write("\n".join(lines) + "\n")
+
+    typecheck_time = measure(["-typecheck"], source_path, object_path)
+    compile_time = measure(["-c"], source_path, object_path)
+
+print(f"{args.statements} statements: typecheck {typecheck_time * 1000:.1f} ms, compile {compile_time * 1000:.1f} ms, "
+      f"difference {(compile_time - typecheck_time) * 1000:.1f} ms")
@@ -0,0 +1,252 @@
+// The benchmarks of bench/std/benchmarks.cx implemented with the C++ standard library, measured the same way as
+// std/Benchmark.cx does, and written to the same JSON format. Reads the number of elements from the BENCH_SIZE
+// environment variable.
+//
+// Usage: BENCH_SIZE=100000 bench_std_baseline results.json
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// Prevents the optimizer from removing the computation of `value`, like blackBox in std/Benchmark.cx.
+template<typename T>
+static void blackBox(T value) {
+#ifdef _MSC_VER
+    static volatile T sink;
+    sink = value;
+#else
+    __asm__ volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+static int64_t monotonicNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Benchmark {
+    std::string name;
+    int sampleCount = 10;
+    int64_t minimumSampleTime = 10000000;
+    int64_t warmupTime = 100000000;
+    int64_t iterationsPerSample = 0;
+    std::vector<double> samples;
+
+    void measure(const std::function<void()>& body) {
+        samples.clear();
+        int64_t iterations = 1;
+        auto warmupEnd = monotonicNanoseconds() + warmupTime;
+
+        while (true) {
+            auto start = monotonicNanoseconds();
+            for (auto remaining = iterations; remaining > 0; remaining--) {
+                body();
+            }
+            auto end = monotonicNanoseconds();
+            auto elapsed = end - start;
+
+            if (elapsed < minimumSampleTime) {
+                auto scaled = elapsed > 0 ? minimumSampleTime * iterations / elapsed * 6 / 5 + 1 : iterations * 100;
+                iterations = std::min(scaled, iterations * 100);
+            } else if (end >= warmupEnd) {
+                break;
+            }
+        }
+
+        iterationsPerSample = iterations;
+
+        for (int sample = 0; sample < sampleCount; sample++) {
+            auto start = monotonicNanoseconds();
+            for (auto remaining = iterations; remaining > 0; remaining--) {
+                body();
+            }
+            samples.push_back(double(monotonicNanoseconds() - start) / double(iterations));
+        }
+    }
+
+    double mean() const {
+        double sum = 0;
+        for (auto sample : samples) sum += sample;
+        return samples.empty() ? 0 : sum / double(samples.size());
+    }
+
+    double median() const {
+        if (samples.empty()) return 0;
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto middle = sorted.size() / 2;
+        return sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+    }
+
+    double standardDeviation() const {
+        if (samples.size() < 2) return 0;
+        auto average = mean();
+        double sumOfSquares = 0;
+        for (auto sample : samples) sumOfSquares += (sample - average) * (sample - average);
+        return std::sqrt(sumOfSquares / double(samples.size() - 1));
+    }
+};
+
+static std::vector<int> randomNumbers(int count) {
+    std::vector<int> numbers;
+    numbers.reserve(count);
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        numbers.push_back(int(state % uint64_t(count * 4)));
+    }
+    return numbers;
+}
+
+static std::string makeText(int wordCount) {
+    std::string text;
+    for (int i = 0; i < wordCount; i++) {
+        if (i != 0) text.push_back(' ');
+        for (int j = 0; j < i % 8 + 1; j++) {
+            text.push_back(char('a' + (i + j) % 26));
+        }
+    }
+    return text;
+}
+
+static std::vector<std::string_view> split(std::string_view text, char delimiter) {
+    std::vector<std::string_view> tokens;
+    size_t start = 0;
+    while (true) {
+        auto end = text.find(delimiter, start);
+        if (end == std::string_view::npos) end = text.size();
+        tokens.push_back(text.substr(start, end - start));
+        if (end == text.size()) break;
+        start = end + 1;
+    }
+    return tokens;
+}
+
+int main(int argc, const char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: BENCH_SIZE=<elements> %s <results.json>\n", argv[0]);
+        return 2;
+    }
+
+    int size = 1000;
+    if (auto* value = getenv("BENCH_SIZE")) size = atoi(value);
+    if (size <= 0) {
+        fprintf(stderr, "invalid BENCH_SIZE\n");
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks;
+    auto run = [&](const char* name, auto&& body) {
+        Benchmark benchmark;
+        benchmark.name = name;
+        if (size >= 1000000) {
+            benchmark.sampleCount = 3;
+            benchmark.warmupTime = 0;
+        }
+        benchmark.measure(body);
+        fprintf(stderr, "%s: %.0f ns/op\n", name, benchmark.mean());
+        benchmarks.push_back(std::move(benchmark));
+    };
+
+    auto keys = randomNumbers(size);
+    auto text = makeText(size);
+
+    run("benchmarkListPush", [&] {
+        std::vector<int> list;
+        for (int i = 0; i < size; i++) list.push_back(i);
+        blackBox(list.size());
+    });
+    run("benchmarkMapInsert", [&] {
+        std::unordered_map<int, int> map;
+        for (auto key : keys) map.emplace(key, key);
+        blackBox(map.size());
+    });
+    {
+        std::unordered_map<int, int> map;
+        for (auto key : keys) map.emplace(key, key);
+        run("benchmarkMapLookup", [&] {
+            int sum = 0;
+            for (auto key : keys) sum += map.find(key)->second;
+            blackBox(sum);
+        });
+    }
+    run("benchmarkOrderedMapInsert", [&] {
+        std::map<int, int> map;
+        for (auto key : keys) map.emplace(key, key);
+        blackBox(map.size());
+    });
+    {
+        std::map<int, int> map;
+        for (auto key : keys) map.emplace(key, key);
+        run("benchmarkOrderedMapLookup", [&] {
+            int sum = 0;
+            for (auto key : keys) sum += map.find(key)->second;
+            blackBox(sum);
+        });
+    }
+    run("benchmarkSetInsert", [&] {
+        std::unordered_set<int> set;
+        for (auto key : keys) set.insert(key);
+        blackBox(set.size());
+    });
+    run("benchmarkStringBufferAppend", [&] {
+        std::string buffer;
+        for (int i = 0; i < size; i++) buffer += "word ";
+        blackBox(buffer.size());
+    });
+    run("benchmarkStringSplit", [&] { blackBox(split(text, ' ').size()); });
+    {
+        std::vector<int> sorted;
+        sorted.reserve(size);
+        run("benchmarkSort", [&] {
+            sorted.assign(keys.begin(), keys.end());
+            std::sort(sorted.begin(), sorted.end());
+            blackBox(sorted[0]);
+        });
+    }
+    {
+        const char* path = "std-benchmark-input.txt";
+        std::ofstream(path, std::ios::binary) << text;
+        run("benchmarkReadFile", [&] {
+            auto* file = fopen(path, "rb");
+            fseek(file, 0, SEEK_END);
+            std::string content(ftell(file), '\0');
+            fseek(file, 0, SEEK_SET);
+            fread(content.data(), 1, content.size(), file);
+            fclose(file);
+            blackBox(content.size());
+        });
+        remove(path);
+    }
+    run("benchmarkPrint", [&] {
+        for (int i = 0; i < size; i++) printf("%d\n", i);
+    });
+
+    auto* file = fopen(argv[1], "w");
+    if (!file) {
+        fprintf(stderr, "couldn't open '%s' for writing benchmark results\n", argv[1]);
+        return 1;
+    }
+    fprintf(file, "{\n  \"backend\": \"c++\",\n  \"optimizationLevel\": 2,\n  \"benchmarks\": [");
+    for (auto& benchmark : benchmarks) {
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"iterations\": %lld, \"samples\": %zu, \"mean\": %g, \"median\": %g, \"min\": %g, \"max\": %g, \"stddev\": %g}",
+                &benchmark == &benchmarks.front() ? "" : ",", benchmark.name.c_str(), (long long) benchmark.iterationsPerSample, benchmark.samples.size(),
+                benchmark.mean(), benchmark.median(), *std::min_element(benchmark.samples.begin(), benchmark.samples.end()),
+                *std::max_element(benchmark.samples.begin(), benchmark.samples.end()), benchmark.standardDeviation());
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    return 0;
+}
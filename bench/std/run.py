@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+# Runs bench/std/benchmarks.cx with each backend over sizes from 1e3 to 1e7 elements, and the equivalent C++ baseline
+# in bench/std/baseline.cpp, then prints the time per element of each benchmark side by side. Run with the bench_std,
+# bench_std_llvm or bench_std_c targets, or:
+#
+#   bench/std/run.py --cx path/to/cx --baseline path/to/bench_std_baseline --output results.json
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+arg_parser = argparse.ArgumentParser()
+arg_parser.add_argument("--cx", help="path to cx compiler executable", default="cx")
+arg_parser.add_argument("--baseline", help="path to the bench_std_baseline executable, omit to skip the C++ baseline")
+arg_parser.add_argument("--backends", help="comma-separated cx backends to benchmark", default="llvm,c")
+arg_parser.add_argument("--sizes", help="comma-separated numbers of elements", default="1000,10000,100000,1000000,10000000")
+arg_parser.add_argument("--optimization-level", help="optimization level to compile the benchmarks with", type=int, default=2)
+arg_parser.add_argument("--output", help="path of the JSON file to write all results to")
+args = arg_parser.parse_args()
+
+source_path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "benchmarks.cx")
+sizes = [int(size) for size in args.sizes.split(",")]
+configurations = args.backends.split(",") + (["c++"] if args.baseline else [])
+
+# results[configuration][size][benchmark] = mean nanoseconds per iteration
+results = {configuration: {} for configuration in configurations}
+
+with tempfile.TemporaryDirectory() as directory:
+    for size in sizes:
+        environment = dict(os.environ, BENCH_SIZE=str(size))
+        for configuration in configurations:
+            results_path = os.path.join(directory, f"{configuration}-{size}.json")
+            if configuration == "c++":
+                command = [os.path.abspath(args.baseline), results_path]
+            else:
+                command = [args.cx, "bench", source_path, f"-backend={configuration}", f"-O{args.optimization_level}", f"-results={results_path}"]
+
+            print(f"Running {configuration} with {size} elements...", file=sys.stderr)
+            # The print benchmark writes to the standard output, so discard it.
+            exit_status = subprocess.call(command, cwd=directory, env=environment, stdout=subprocess.DEVNULL)
+            if exit_status != 0:
+                sys.exit(exit_status)
+
+            with open(results_path) as file:
+                benchmarks = json.load(file)["benchmarks"]
+            results[configuration][size] = {benchmark["name"]: benchmark["mean"] for benchmark in benchmarks}
+
+names = list(results[configurations[0]][sizes[0]])
+print(f"{'ns per element':<30} {'size':>9}" + "".join(f"{configuration:>10}" for configuration in configurations))
+for name in names:
+    for size in sizes:
+        row = f"{name.removeprefix('benchmark'):<30} {size:>9}"
+        for configuration in configurations:
+            mean = results[configuration][size].get(name)
+            row += f"{mean / size:>10.2f}" if mean is not None else f"{'-':>10}"
+        print(row)
+
+if args.output:
+    with open(args.output, "w") as output:
+        json.dump({"optimizationLevel": args.optimization_level, "results": results}, output, indent=2, sort_keys=True)
+        output.write("\n")
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+
+# Measures typechecking time of a generated file with many calls to overloaded function templates: 10K println calls
+# with varying argument types, and comparisons that resolve operator== among the templates in std. Run with:
+#
+#   bench/typecheck-calls.py --cx path/to/cx
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+arg_parser = argparse.ArgumentParser()
+arg_parser.add_argument("--cx", help="path to cx compiler executable", default="cx")
+arg_parser.add_argument("--calls", help="number of println calls to generate", type=int, default=10000)
+arg_parser.add_argument("--runs", help="number of times to typecheck the file", type=int, default=5)
+args = arg_parser.parse_args()
+
+lines = ["void main() {", "    var i = 42;", "    var f = 1.5;", '    var s = "text";', "    var b = true;"]
+call_templates = [
+    '    println("value ", i);',
+    "    println(i, f);",
+    "    println(s);",
+    '    println("flag ", b, " ", s);',
+    "    println(i == 42, s == s);",
+]
+for index in range(args.calls):
+    lines.append(call_templates[index % len(call_templates)])
+lines.append("}")
+
+with tempfile.TemporaryDirectory() as directory:
+    source_path = os.path.join(directory, "calls.cx")
+    with open(source_path, "w") as source:
+        source.write("\n".join(lines) + "\n")
+
+    timings = []
+    for _ in range(args.runs):
+        start = time.perf_counter()
+        exit_status = subprocess.call([args.cx, "-typecheck", source_path])
+        timings.append(time.perf_counter() - start)
+        if exit_status != 0:
+            sys.exit(exit_status)
+
+timings.sort()
+print(f"{args.calls} calls: min {timings[0] * 1000:.1f} ms, median {timings[len(timings) // 2] * 1000:.1f} ms")
@@ -90,7 +90,7 @@ llvm::raw_ostream& operator<<(llvm::raw_ostream& stream, const Decl& decl) {
     }
     case DeclKind::VarDecl: {
         auto& varDecl = llvm::cast<VarDecl>(decl);
-        stream << "VarDecl " << varDecl.getName() << " ";
+        stream << (varDecl.isThreadLocal ? "thread_local " : "") << "VarDecl " << varDecl.getName() << " ";
         if (varDecl.initializer) {
             stream << *varDecl.initializer;
         }
@@ -18,7 +18,20 @@ FunctionProto FunctionProto::instantiate(const llvm::StringMap<Type>& genericArg
 FunctionDecl* FunctionTemplate::instantiate(const llvm::StringMap<Type>& genericArgs) {
     ASSERT(!genericParams.empty() && !genericArgs.empty());
 
-    auto orderedGenericArgs = map(genericParams, [&](auto& genericParam) { return genericArgs.find(genericParam.getName())->second; });
+    std::vector<Type> orderedGenericArgs;
+    orderedGenericArgs.reserve(genericParams.size());
+
+    for (auto& genericParam : genericParams) {
+        if (genericParam.isPack) {
+            // Flatten the pack so that instantiations are keyed and mangled by their element types.
+            auto pack = genericArgs.find(getPackKey(genericParam.getName()))->second;
+            for (auto& element : pack.getTupleElements()) {
+                orderedGenericArgs.push_back(element.type);
+            }
+        } else {
+            orderedGenericArgs.push_back(genericArgs.find(genericParam.getName())->second);
+        }
+    }
 
     auto it = instantiations.find(orderedGenericArgs);
     if (it != instantiations.end()) return it->second;
@@ -57,13 +70,31 @@ bool FunctionDecl::signatureMatches(const FunctionDecl& other, bool matchReceive
     return true;
 }
 
+/// Instantiates a function body. If the function has a parameter pack that was expanded, the expanded parameters are
+/// made available to the body under the pack's key, so that 'for (var x in pack)' and 'f(pack...)' can be expanded.
+static std::vector<Stmt*> instantiateBody(const std::vector<Stmt*>& body, llvm::ArrayRef<ParamDecl> params, llvm::ArrayRef<ParamDecl> instantiatedParams,
+                                          const llvm::StringMap<Type>& genericArgs) {
+    if (params.empty() || !params.back().isPack || (!instantiatedParams.empty() && instantiatedParams.back().isPack)) {
+        return ::instantiate(body, genericArgs);
+    }
+
+    std::vector<TupleElement> expandedParams;
+    for (auto& param : instantiatedParams.drop_front(params.size() - 1)) {
+        expandedParams.push_back({param.getName().str(), param.type});
+    }
+
+    auto bodyGenericArgs = genericArgs;
+    bodyGenericArgs[getPackKey(params.back().getName())] = TupleType::get(std::move(expandedParams));
+    return ::instantiate(body, bodyGenericArgs);
+}
+
 FunctionDecl* FunctionDecl::instantiate(const llvm::StringMap<Type>& genericArgs, llvm::ArrayRef<Type> genericArgsArray) {
     if (auto methodDecl = llvm::dyn_cast<MethodDecl>(this)) {
         return methodDecl->instantiate(genericArgs, genericArgsArray, *getTypeDecl());
     } else {
         auto proto = this->proto.instantiate(genericArgs);
         auto instantiation = new FunctionDecl(std::move(proto), genericArgsArray, accessLevel, module, location);
-        instantiation->body = ::instantiate(*body, genericArgs);
+        instantiation->body = instantiateBody(*body, getParams(), instantiation->getParams(), genericArgs);
         return instantiation;
     }
 }
@@ -92,7 +123,7 @@ MethodDecl* MethodDecl::instantiate(const llvm::StringMap<Type>& genericArgs, ll
         auto proto = methodDecl->proto.instantiate(genericArgs);
         auto instantiation = new MethodDecl(std::move(proto), typeDecl, genericArgsArray, accessLevel, methodDecl->getLocation());
         if (methodDecl->body) {
-            instantiation->body = ::instantiate(*methodDecl->body, genericArgs);
+            instantiation->body = instantiateBody(*methodDecl->body, methodDecl->getParams(), instantiation->getParams(), genericArgs);
         }
         return instantiation;
     }
@@ -121,8 +152,32 @@ FieldDecl FieldDecl::instantiate(const llvm::StringMap<Type>& genericArgs, TypeD
 }
 
 std::vector<ParamDecl> cx::instantiateParams(llvm::ArrayRef<ParamDecl> params, const llvm::StringMap<Type>& genericArgs) {
-    return map(params,
-               [&](const ParamDecl& param) { return ParamDecl(param.type.resolve(genericArgs), param.getName().str(), param.isPublic, param.getLocation()); });
+    std::vector<ParamDecl> instantiatedParams;
+    instantiatedParams.reserve(params.size());
+
+    for (auto& param : params) {
+        if (param.isPack) {
+            // A function has at most one variadic generic parameter, so the pack key in the map belongs to it.
+            auto pack = llvm::find_if(genericArgs, [](auto& entry) { return entry.getKey().ends_with("..."); });
+
+            if (pack != genericArgs.end()) {
+                auto genericParamName = pack->getKey().drop_back(3);
+                auto elementGenericArgs = genericArgs;
+
+                for (const auto& element : llvm::enumerate(pack->getValue().getTupleElements())) {
+                    elementGenericArgs[genericParamName] = element.value().type;
+                    auto name = "__" + param.getName().str() + "_" + std::to_string(element.index());
+                    instantiatedParams.emplace_back(param.type.resolve(elementGenericArgs), std::move(name), param.isPublic, param.getLocation());
+                }
+                continue;
+            }
+        }
+
+        instantiatedParams.emplace_back(param.type.resolve(genericArgs), param.getName().str(), param.isPublic, param.getLocation());
+        instantiatedParams.back().isPack = param.isPack;
+    }
+
+    return instantiatedParams;
 }
 
 std::string TypeDecl::getQualifiedName() const {
@@ -168,6 +223,54 @@ ConstructorDecl* TypeDecl::addAutogeneratedConstructor() {
     return autogeneratedInit;
 }
 
+// Adds a column field 'Field[*] name' for each field 'Field name' of the element type of a SoAList, and the private
+// methods that operate on every column:
+//   void storeElement(int index, Element element) { this.x[index] = element.x; ... }
+//   Element loadElement(int index) { Element element = undefined; element.x = this.x[index]; ...; return element; }
+//   void reallocateColumns(int newCapacity) { this.x = reallocateColumn(this.x, this.capacity, newCapacity); ... }
+//   void deallocateColumns() { deallocate(this.x); ... }
+void TypeDecl::addColumns(const TypeDecl& elementTypeDecl) {
+    auto elementType = genericArgs.front();
+    auto location = getLocation();
+    auto member = [&](const char* base, llvm::StringRef name) { return new MemberExpr(new VarExpr(base, location), name.str(), location); };
+    auto call = [&](const char* function, std::vector<NamedValue>&& args) {
+        return new CallExpr(new VarExpr(function, location), std::move(args), std::vector<Type>(), location);
+    };
+    auto addColumnMethod = [&](const char* name, std::vector<ParamDecl>&& params, Type returnType) {
+        auto* method = new MethodDecl(FunctionProto(name, std::move(params), returnType, false, false), *this, {}, AccessLevel::Private, location);
+        method->body.emplace();
+        addMethod(method);
+        return method;
+    };
+
+    auto* storeElement =
+        addColumnMethod("storeElement", {ParamDecl(Type::getInt(), "index", false, location), ParamDecl(elementType, "element", false, location)}, Type::getVoid());
+    auto* loadElement = addColumnMethod("loadElement", {ParamDecl(Type::getInt(), "index", false, location)}, elementType);
+    auto* reallocateColumns = addColumnMethod("reallocateColumns", {ParamDecl(Type::getInt(), "newCapacity", false, location)}, Type::getVoid());
+    auto* deallocateColumns = addColumnMethod("deallocateColumns", {}, Type::getVoid());
+
+    auto* element = new VarDecl(elementType, "element", new UndefinedLiteralExpr(location), loadElement, AccessLevel::None, module, location);
+    loadElement->body->push_back(new VarStmt(element));
+
+    for (auto& field : elementTypeDecl.fields) {
+        auto name = field.getName();
+        addField(FieldDecl(ArrayType::get(field.type, ArrayType::UnknownSize, location), name.str(), nullptr, *this, AccessLevel::Default, location));
+
+        auto* column = new IndexExpr(member("this", name), new VarExpr("index", location), location);
+        storeElement->body->push_back(new ExprStmt(new BinaryExpr(Token::Assignment, column, member("element", name), location)));
+
+        column = new IndexExpr(member("this", name), new VarExpr("index", location), location);
+        loadElement->body->push_back(new ExprStmt(new BinaryExpr(Token::Assignment, member("element", name), column, location)));
+
+        auto* newColumn = call("reallocateColumn", {member("this", name), member("this", "capacity"), new VarExpr("newCapacity", location)});
+        reallocateColumns->body->push_back(new ExprStmt(new BinaryExpr(Token::Assignment, member("this", name), newColumn, location)));
+
+        deallocateColumns->body->push_back(new ExprStmt(call("deallocate", {member("this", name)})));
+    }
+
+    loadElement->body->push_back(new ReturnStmt(new VarExpr("element", location), location));
+}
+
 std::vector<ConstructorDecl*> TypeDecl::getConstructors() const {
     std::vector<ConstructorDecl*> constructors;
 
@@ -201,6 +304,14 @@ Type TypeDecl::getTypeForPassing() const {
     }
 }
 
+bool TypeDecl::isStructOfArrays() const {
+    return instantiatedFrom && name == "SoAList" && module.name == "std";
+}
+
+bool TypeDecl::isStructOfArraysElement() const {
+    return instantiatedFrom && name == "SoAListElement" && module.name == "std";
+}
+
 unsigned TypeDecl::getFieldIndex(const FieldDecl* field) const {
     for (const auto& p : llvm::enumerate(fields)) {
         if (&p.value() == field) {
@@ -210,6 +321,45 @@ unsigned TypeDecl::getFieldIndex(const FieldDecl* field) const {
     llvm_unreachable("unknown field");
 }
 
+FieldDecl* TypeDecl::getField(llvm::StringRef name) {
+    for (auto& field : fields) {
+        if (field.getName() == name) return &field;
+    }
+    return nullptr;
+}
+
+llvm::ArrayRef<Decl*> TypeDecl::findMembers(Identifier name) {
+    if (fields.size() != indexedFieldCount || methods.size() != indexedMethodCount) {
+        buildMemberIndex();
+    }
+
+    auto it = memberIndex.find(name);
+    if (it == memberIndex.end()) return {};
+    return it->second;
+}
+
+void TypeDecl::buildMemberIndex() {
+    memberIndex.clear();
+
+    for (auto* decl : methods) {
+        if (auto* functionDecl = llvm::dyn_cast<FunctionDecl>(decl)) {
+            memberIndex[Identifier::get(functionDecl->getName())].push_back(decl);
+        } else if (auto* functionTemplate = llvm::dyn_cast<FunctionTemplate>(decl)) {
+            memberIndex[Identifier::get(functionTemplate->getQualifiedName())].push_back(decl);
+        }
+    }
+
+    for (auto& field : fields) {
+        auto name = Identifier::get(field.getName());
+        auto qualifiedName = Identifier::get(field.getQualifiedName());
+        memberIndex[name].push_back(&field);
+        if (qualifiedName != name) memberIndex[qualifiedName].push_back(&field);
+    }
+
+    indexedFieldCount = fields.size();
+    indexedMethodCount = methods.size();
+}
+
 TypeDecl* TypeTemplate::instantiate(const llvm::StringMap<Type>& genericArgs) {
     ASSERT(!genericParams.empty() && !genericArgs.empty());
     auto orderedGenericArgs = map(genericParams, [&](auto& genericParam) { return genericArgs.find(genericParam.getName())->second; });
@@ -320,7 +470,10 @@ Decl* Decl::instantiate(const llvm::StringMap<Type>& genericArgs, llvm::ArrayRef
 
                 for (auto& genericParam : functionTemplate->genericParams) {
                     genericParams.emplace_back(genericParam.getName().str(), genericParam.getLocation());
-                    genericParams.back().constraints = genericParam.constraints;
+                    for (Type constraint : genericParam.constraints) {
+                        genericParams.back().constraints.push_back(constraint.resolve(genericArgs));
+                    }
+                    genericParams.back().isPack = genericParam.isPack;
                 }
 
                 auto accessLevel = methodInstantiation->accessLevel;
@@ -328,6 +481,12 @@ Decl* Decl::instantiate(const llvm::StringMap<Type>& genericArgs, llvm::ArrayRef
             }
         }
 
+        if (instantiation->isStructOfArrays()) {
+            if (auto* elementTypeDecl = genericArgsArray.front().getDecl(); elementTypeDecl && elementTypeDecl->isStruct()) {
+                instantiation->addColumns(*elementTypeDecl);
+            }
+        }
+
         return instantiation;
     }
     case DeclKind::TypeTemplate:
@@ -4,11 +4,13 @@
 #include <unordered_map>
 #include <vector>
 #pragma warning(push, 0)
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/Support/Casting.h>
 #pragma warning(pop)
 #include "../support/utility.h"
 #include "expr.h"
+#include "identifier.h"
 #include "location.h"
 #include "stmt.h"
 #include "type.h"
@@ -141,10 +143,20 @@ struct ParamDecl : VariableDecl, Movable {
     std::string name;
     Location location;
     bool isPublic;
+    /// Whether this is a parameter pack, declared using 'T... name', that is expanded into one parameter per
+    /// element of the variadic generic parameter when the function is instantiated.
+    bool isPack = false;
 };
 
 std::vector<ParamDecl> instantiateParams(llvm::ArrayRef<ParamDecl> params, const llvm::StringMap<Type>& genericArgs);
 
+/// Returns the key under which the elements of the given pack are stored in a generic argument map. For a variadic
+/// generic parameter the value is a tuple of the element types, for a parameter pack it's a tuple of the expanded
+/// parameter names and types.
+inline std::string getPackKey(llvm::StringRef name) {
+    return name.str() + "...";
+}
+
 struct GenericParamDecl : Decl {
     GenericParamDecl(std::string&& name, Location location) : Decl(DeclKind::GenericParamDecl, AccessLevel::None), name(std::move(name)), location(location) {}
     llvm::StringRef getName() const override { return name; }
@@ -155,6 +167,8 @@ struct GenericParamDecl : Decl {
     std::string name;
     llvm::SmallVector<Type, 1> constraints;
     Location location;
+    /// Whether this is a variadic generic parameter, declared using 'T...', that binds to any number of types.
+    bool isPack = false;
 };
 
 struct FunctionProto {
@@ -201,6 +215,10 @@ struct FunctionDecl : Decl {
     Location location;
     Module& module;
     bool typechecked;
+    /// For lambdas, the local variables and parameters of enclosing functions that the lambda refers to.
+    std::vector<VariableDecl*> captures;
+    /// For lambdas used as closures, the struct type holding pointers to the captured variables.
+    TypeDecl* closureType = nullptr;
 
 protected:
     FunctionDecl(DeclKind kind, FunctionProto&& proto, std::vector<Type>&& genericArgs, AccessLevel accessLevel, Module& module, Location location)
@@ -276,6 +294,7 @@ struct TypeDecl : Decl {
     void addField(FieldDecl&& field);
     void addMethod(Decl* decl);
     ConstructorDecl* addAutogeneratedConstructor();
+    void addColumns(const TypeDecl& elementTypeDecl);
     std::vector<ConstructorDecl*> getConstructors() const;
     DestructorDecl* getDestructor() const;
     Type getType(Mutability mutability = Mutability::Mutable) const;
@@ -284,7 +303,16 @@ struct TypeDecl : Decl {
     bool isStruct() const { return tag == TypeTag::Struct; }
     bool isInterface() const { return tag == TypeTag::Interface; }
     bool isUnion() const { return tag == TypeTag::Union; }
+    /// Whether this is an instantiation of the standard library's SoAList, which stores each field of its elements in a
+    /// separate column field.
+    bool isStructOfArrays() const;
+    /// Whether this is an instantiation of SoAListElement, through which the fields of a SoAList element are accessed.
+    bool isStructOfArraysElement() const;
     unsigned getFieldIndex(const FieldDecl* field) const;
+    FieldDecl* getField(llvm::StringRef name);
+    /// Returns the members that the given name refers to inside this type: methods by their name, method templates by
+    /// their qualified name, and fields by either.
+    llvm::ArrayRef<Decl*> findMembers(Identifier name);
     Module* getModule() const override { return &module; }
     static bool classof(const Decl* d) { return d->isTypeDecl(); }
     TypeDecl(DeclKind kind, TypeTag tag, std::string&& name, AccessLevel accessLevel, Module& module, const TypeDecl* instantiatedFrom, Location location)
@@ -300,6 +328,16 @@ struct TypeDecl : Decl {
     Module& module;
     const TypeDecl* instantiatedFrom;
     bool packed = false;
+    /// For closure types, the lambda that is called through values of this type.
+    FunctionDecl* closureFunction = nullptr;
+
+private:
+    void buildMemberIndex();
+
+    /// Members by name for findMembers(). Rebuilt when fields or methods have been added since it was built.
+    llvm::DenseMap<Identifier, llvm::SmallVector<Decl*, 1>> memberIndex;
+    size_t indexedFieldCount = 0;
+    size_t indexedMethodCount = 0;
 };
 
 struct TypeTemplate : Decl {
@@ -360,6 +398,8 @@ struct VarDecl : VariableDecl, Movable {
     Expr* initializer;
     Location location;
     Module& module;
+    /// Whether this is a global variable with a separate instance for each thread, declared using 'thread_local'.
+    bool isThreadLocal = false;
 };
 
 struct ImportDecl : Decl {
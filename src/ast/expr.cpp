@@ -1,5 +1,6 @@
 #include "expr.h"
 #pragma warning(push, 0)
+#include <llvm/ADT/StringSwitch.h>
 #include <llvm/Support/ErrorHandling.h>
 #pragma warning(pop)
 #include "ast.h"
@@ -193,7 +194,23 @@ Expr* Expr::instantiate(const llvm::StringMap<Type>& genericArgs) const {
     case ExprKind::CallExpr: {
         auto* callExpr = llvm::cast<CallExpr>(this);
         auto callee = callExpr->getCallee().instantiate(genericArgs);
-        auto args = map(callExpr->getArgs(), [&](auto& arg) { return NamedValue(arg.getName().str(), arg.getValue()->instantiate(genericArgs)); });
+        std::vector<NamedValue> args;
+        args.reserve(callExpr->getArgs().size());
+
+        for (auto& arg : callExpr->getArgs()) {
+            // Expand 'f(pack...)' into 'f(__pack_0, __pack_1, ...)'.
+            if (auto* varExpr = llvm::dyn_cast<VarExpr>(arg.getValue()); varExpr && varExpr->getIdentifier().ends_with("...")) {
+                auto pack = genericArgs.find(varExpr->getIdentifier());
+                if (pack != genericArgs.end()) {
+                    for (auto& expandedParam : pack->getValue().getTupleElements()) {
+                        args.emplace_back("", new VarExpr(std::string(expandedParam.name), varExpr->getLocation()), arg.getLocation());
+                    }
+                    continue;
+                }
+            }
+            args.emplace_back(arg.getName().str(), arg.getValue()->instantiate(genericArgs));
+        }
+
         auto callGenericArgs = map(callExpr->getGenericArgs(), [&](Type type) { return type.resolve(genericArgs); });
         return new CallExpr(callee, std::move(args), std::move(callGenericArgs), callExpr->getLocation());
     }
@@ -287,6 +304,15 @@ llvm::StringRef CallExpr::getFunctionName() const {
     }
 }
 
+/// Returns true if this is a call to one of the builtin atomic operations, e.g. 'atomicFetchAdd(&counter, 1)'.
+bool CallExpr::isBuiltinAtomic() const {
+    if (!getCallee().isVarExpr()) return false;
+    return llvm::StringSwitch<bool>(getFunctionName())
+        .Cases("atomicLoad", "atomicStore", "atomicExchange", "atomicCompareExchange", true)
+        .Cases("atomicFetchAdd", "atomicFetchSub", "atomicFetchAnd", "atomicFetchOr", "atomicFetchXor", true)
+        .Default(false);
+}
+
 static Type getReceiverType(const CallExpr& call) {
     if (call.getCallee().isMemberExpr()) {
         return call.getReceiver()->getType().removeOptional().removePointer();
@@ -208,6 +208,8 @@ struct CallExpr : Expr {
     bool isMethodCall() const { return callee->isMemberExpr(); }
     bool isBuiltinConversion() const { return Type::isBuiltinScalar(getFunctionName()); }
     bool isBuiltinCast() const { return getFunctionName() == "cast"; }
+    bool isBuiltinAtomic() const;
+    bool isBuiltinTypeTrait() const { return getCallee().isVarExpr() && getFunctionName() == "isTriviallyRelocatable"; }
     bool isMoveInit() const;
     const Expr* getReceiver() const;
     Expr* getReceiver();
@@ -0,0 +1,11 @@
+#include "identifier.h"
+#pragma warning(push, 0)
+#include <llvm/Support/Allocator.h>
+#pragma warning(pop)
+
+using namespace cx;
+
+Identifier Identifier::get(llvm::StringRef name) {
+    static llvm::StringMap<char, llvm::BumpPtrAllocator> identifierTable;
+    return Identifier(&*identifierTable.try_emplace(name).first);
+}
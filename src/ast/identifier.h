@@ -0,0 +1,36 @@
+#pragma once
+
+#pragma warning(push, 0)
+#include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#pragma warning(pop)
+
+namespace cx {
+
+/// An interned name. All identifiers with the same spelling share a single entry in the identifier table, so they can
+/// be compared and hashed by pointer instead of by their characters.
+struct Identifier {
+    Identifier() : entry(nullptr) {}
+    static Identifier get(llvm::StringRef name);
+    llvm::StringRef str() const { return entry->getKey(); }
+    explicit operator bool() const { return entry != nullptr; }
+    bool operator==(Identifier other) const { return entry == other.entry; }
+    bool operator!=(Identifier other) const { return entry != other.entry; }
+
+private:
+    friend struct llvm::DenseMapInfo<Identifier>;
+    explicit Identifier(const llvm::StringMapEntry<char>* entry) : entry(entry) {}
+
+    const llvm::StringMapEntry<char>* entry;
+};
+
+} // namespace cx
+
+template<> struct llvm::DenseMapInfo<cx::Identifier> {
+    using EntryInfo = DenseMapInfo<const llvm::StringMapEntry<char>*>;
+    static cx::Identifier getEmptyKey() { return cx::Identifier(EntryInfo::getEmptyKey()); }
+    static cx::Identifier getTombstoneKey() { return cx::Identifier(EntryInfo::getTombstoneKey()); }
+    static unsigned getHashValue(cx::Identifier identifier) { return EntryInfo::getHashValue(identifier.entry); }
+    static bool isEqual(cx::Identifier a, cx::Identifier b) { return a == b; }
+};
@@ -49,9 +49,24 @@ struct Scope {
 struct SymbolTable {
     SymbolTable() : globalScope(nullptr, this) {}
     Scope& getCurrentScope() { return *scopes.back(); }
-    void add(llvm::StringRef name, Decl* decl) { scopes.back()->decls[name].push_back(decl); }
-    void addGlobal(llvm::StringRef name, Decl* decl) { scopes.front()->decls[name].push_back(decl); }
-    void addIdentifierReplacement(llvm::StringRef name, llvm::StringRef replacement) { identifierReplacements.try_emplace(name, replacement); }
+    llvm::ArrayRef<Scope*> getScopes() const { return scopes; }
+    /// Returns a counter that changes whenever a lookup in the global scope could return a different result.
+    uint64_t getGlobalGeneration() const { return globalGeneration; }
+
+    void add(llvm::StringRef name, Decl* decl) {
+        if (scopes.size() == 1) globalGeneration++;
+        scopes.back()->decls[name].push_back(decl);
+    }
+
+    void addGlobal(llvm::StringRef name, Decl* decl) {
+        globalGeneration++;
+        scopes.front()->decls[name].push_back(decl);
+    }
+
+    void addIdentifierReplacement(llvm::StringRef name, llvm::StringRef replacement) {
+        globalGeneration++;
+        identifierReplacements.try_emplace(name, replacement);
+    }
 
     llvm::ArrayRef<Decl*> findFirst(llvm::StringRef name) const {
         ASSERT(!name.empty());
@@ -110,6 +125,7 @@ private:
     }
 
     llvm::StringRef applyIdentifierReplacements(llvm::StringRef name) const {
+        if (identifierReplacements.empty()) return name;
         llvm::StringRef initialName = name;
         while (true) {
             auto it = identifierReplacements.find(name);
@@ -122,6 +138,7 @@ private:
     std::vector<Scope*> scopes;
     Scope globalScope;
     llvm::StringMap<std::string> identifierReplacements;
+    uint64_t globalGeneration = 0;
 };
 
 /// Container for the AST of a whole module, comprised of one or more SourceFiles.
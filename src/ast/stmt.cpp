@@ -1,6 +1,7 @@
 #include "stmt.h"
 #include "ast.h"
 #include "decl.h"
+#include "module.h"
 
 using namespace cx;
 
@@ -82,6 +83,12 @@ Stmt* Stmt::instantiate(const llvm::StringMap<Type>& genericArgs) const {
     }
     case StmtKind::ForEachStmt: {
         auto* forEachStmt = llvm::cast<ForEachStmt>(this);
+
+        if (auto* rangeVarExpr = llvm::dyn_cast<VarExpr>(forEachStmt->range)) {
+            auto pack = genericArgs.find(getPackKey(rangeVarExpr->getIdentifier()));
+            if (pack != genericArgs.end()) return forEachStmt->expandPack(pack->getValue().getTupleElements(), genericArgs);
+        }
+
         // The second argument can be empty because VarDecl instantiation doesn't use it.
         auto variable = llvm::cast<VarDecl>(forEachStmt->variable->instantiate(genericArgs, {}));
         auto range = forEachStmt->range->instantiate(genericArgs);
@@ -105,11 +112,74 @@ Stmt* Stmt::instantiate(const llvm::StringMap<Type>& genericArgs) const {
     llvm_unreachable("all cases handled");
 }
 
+// Unrolls 'for (var id in pack) { ... }' into one block per expanded parameter:
+// {
+//     { var id = __pack_0; ... }
+//     { var id = __pack_1; ... }
+// }
+Stmt* ForEachStmt::expandPack(llvm::ArrayRef<TupleElement> expandedParams, const llvm::StringMap<Type>& genericArgs) const {
+    std::vector<Stmt*> blocks;
+    blocks.reserve(expandedParams.size());
+
+    for (auto& expandedParam : expandedParams) {
+        auto initializer = new VarExpr(std::string(expandedParam.name), range->getLocation());
+        auto elementVariable = new VarDecl(variable->type, variable->getName().str(), initializer, variable->parent, AccessLevel::None, *variable->getModule(),
+                                           variable->getLocation());
+        std::vector<Stmt*> block;
+        block.push_back(new VarStmt(elementVariable));
+        auto elementBody = ::instantiate(body, genericArgs);
+        block.insert(block.end(), elementBody.begin(), elementBody.end());
+        blocks.push_back(new CompoundStmt(std::move(block)));
+    }
+
+    return new CompoundStmt(std::move(blocks));
+}
+
 Stmt* WhileStmt::lower() {
     return new ForStmt(nullptr, condition, nullptr, std::move(body), location);
 }
 
-// Lowers 'for (var id in range) { ... }' into:
+static bool isIterator(const TypeDecl* typeDecl) {
+    return typeDecl && llvm::any_of(typeDecl->interfaces, [](Type interface) { return interface.getName() == "Iterator"; });
+}
+
+// Returns the type of the iterator that the for-each loop uses to iterate over the given range, if it's one of the
+// standard library iterators that consist of a 'current' and 'end' field, otherwise null.
+static Type getCountedIteratorType(Type rangeType) {
+    rangeType = rangeType.removePointer();
+    if (rangeType.isArrayType()) {
+        return rangeType.isConstantArray() ? BasicType::get("ArrayIterator", rangeType.getElementType()) : Type();
+    }
+
+    auto* rangeTypeDecl = rangeType.getDecl();
+    if (!rangeTypeDecl || !rangeTypeDecl->getModule() || rangeTypeDecl->getModule()->name != "std") return Type();
+
+    Type iteratorType;
+    if (isIterator(rangeTypeDecl)) {
+        iteratorType = rangeType;
+    } else {
+        for (auto* method : rangeTypeDecl->methods) {
+            auto* methodDecl = llvm::dyn_cast<MethodDecl>(method);
+            if (methodDecl && methodDecl->getName() == "iterator" && methodDecl->getParams().empty()) {
+                iteratorType = methodDecl->getReturnType();
+                break;
+            }
+        }
+    }
+
+    if (!iteratorType || !iteratorType.isBasicType()) return Type();
+    auto name = iteratorType.getName();
+    if (name == "ArrayIterator" || name == "RangeIterator" || name == "ClosedRangeIterator" || name == "StringIterator") return iteratorType;
+    return Type();
+}
+
+// Lowers 'for (var id in range) { ... }' over arrays, strings, and ranges into a counted loop that accesses the fields
+// of the standard library iterator directly, so that no calls are made per iteration:
+// for (var __iterator = range.iterator(); __iterator.current != __iterator.end; __iterator.current++) {
+//     var id = __iterator.current; // '*__iterator.current' for strings
+//     ...
+// }
+// Closed ranges use 'current <= end' as the condition. Other ranges are lowered into:
 // for (var __iterator = range.iterator(); __iterator.hasValue(); __iterator.increment()) {
 //     var id = __iterator.value();
 //     ...
@@ -118,8 +188,7 @@ Stmt* ForEachStmt::lower(int nestLevel) {
     auto iteratorVariableName = "__iterator" + (nestLevel > 0 ? std::to_string(nestLevel) : "");
 
     Expr* iteratorValue;
-    auto* rangeTypeDecl = range->getType().removePointer().getDecl();
-    bool isIterator = rangeTypeDecl && llvm::any_of(rangeTypeDecl->interfaces, [](Type interface) { return interface.getName() == "Iterator"; });
+    bool isIterator = ::isIterator(range->getType().removePointer().getDecl());
 
     if (isIterator) {
         iteratorValue = range;
@@ -132,6 +201,30 @@ Stmt* ForEachStmt::lower(int nestLevel) {
                                        AccessLevel::None, *variable->getModule(), location);
     auto iteratorVarStmt = new VarStmt(iteratorVarDecl);
 
+    if (auto iteratorType = getCountedIteratorType(range->getType())) {
+        auto iteratorField = [&](const char* name) { return new MemberExpr(new VarExpr(std::string(iteratorVariableName), location), name, location); };
+        bool isClosedRange = iteratorType.getName() == "ClosedRangeIterator";
+        auto condition = new BinaryExpr(isClosedRange ? Token::LessOrEqual : Token::NotEqual, iteratorField("current"), iteratorField("end"), location);
+        auto increment = new UnaryExpr(Token::Increment, iteratorField("current"), location);
+
+        Expr* value = iteratorField("current");
+        auto variableType = variable->type;
+        if (iteratorType.getName() == "StringIterator") {
+            value = new UnaryExpr(Token::Star, value, location);
+        } else if (iteratorType.getName() == "ArrayIterator" && !variableType) {
+            // The 'current' field is an unsized array pointer, but the loop variable should be a plain pointer like the
+            // return value of ArrayIterator.value().
+            variableType = Type(iteratorType.getGenericArgs()[0].getPointerTo().getBase(), variableType.getMutability(), variable->getLocation());
+        }
+
+        auto loopVariableVarDecl = new VarDecl(variableType, variable->getName().str(), value, variable->parent, AccessLevel::None, *variable->getModule(),
+                                               variable->getLocation());
+        std::vector<Stmt*> forBody;
+        forBody.push_back(new VarStmt(loopVariableVarDecl));
+        forBody.insert(forBody.end(), body.begin(), body.end());
+        return new ForStmt(iteratorVarStmt, condition, increment, std::move(forBody), location);
+    }
+
     auto iteratorVarExpr = new VarExpr(std::string(iteratorVariableName), location);
     auto hasValueMemberExpr = new MemberExpr(iteratorVarExpr, "hasValue", location);
     auto hasValueCallExpr = new CallExpr(hasValueMemberExpr, std::vector<NamedValue>(), std::vector<Type>(), location);
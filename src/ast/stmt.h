@@ -132,6 +132,7 @@ struct ForEachStmt : Stmt {
     ForEachStmt(VarDecl* variable, Expr* range, std::vector<Stmt*>&& body, Location location)
     : Stmt(StmtKind::ForEachStmt), variable(variable), range(range), body(std::move(body)), location(location) {}
     Stmt* lower(int nestLevel);
+    Stmt* expandPack(llvm::ArrayRef<TupleElement> expandedParams, const llvm::StringMap<Type>& genericArgs) const;
     static bool classof(const Stmt* s) { return s->kind == StmtKind::ForEachStmt; }
 
     VarDecl* variable;
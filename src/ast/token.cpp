@@ -268,6 +268,7 @@ const char* cx::toString(Token::Kind tokenKind) {
         "struct",
         "switch",
         "this",
+        "thread_local",
         "true",
         "undefined",
         "var",
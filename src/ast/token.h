@@ -48,6 +48,7 @@ struct Token {
         Struct,
         Switch,
         This,
+        ThreadLocal,
         True,
         Undefined,
         Var,
@@ -61,6 +61,31 @@ bool Type::isImplicitlyCopyable() const {
     llvm_unreachable("all cases handled");
 }
 
+/// Returns true if values of this type can be copied and moved with memcpy, i.e. the type is
+/// implicitly copyable and neither it nor any of its fields has a destructor.
+bool Type::isTriviallyRelocatable() const {
+    if (!isImplicitlyCopyable()) return false;
+
+    switch (getKind()) {
+    case TypeKind::BasicType:
+        if (auto* typeDecl = getDecl()) {
+            if (typeDecl->getDestructor()) return false;
+            return llvm::all_of(typeDecl->fields, [](auto& field) { return field.type.isTriviallyRelocatable(); });
+        }
+        return true;
+    case TypeKind::ArrayType:
+        return !isConstantArray() || getElementType().isTriviallyRelocatable();
+    case TypeKind::TupleType:
+        return llvm::all_of(llvm::cast<TupleType>(typeBase)->getElements(), [&](auto& element) { return element.type.isTriviallyRelocatable(); });
+    case TypeKind::FunctionType:
+    case TypeKind::PointerType:
+        return true;
+    case TypeKind::UnresolvedType:
+        llvm_unreachable("invalid unresolved type");
+    }
+    llvm_unreachable("all cases handled");
+}
+
 bool Type::isConstantArray() const {
     return isArrayType() && getArraySize() >= 0;
 }
@@ -345,6 +370,11 @@ TypeDecl* Type::getDecl() const {
     return basicType ? basicType->getDecl() : nullptr;
 }
 
+FunctionDecl* Type::getClosureFunction() const {
+    auto* typeDecl = getDecl();
+    return typeDecl ? typeDecl->closureFunction : nullptr;
+}
+
 DestructorDecl* Type::getDestructor() const {
     auto* typeDecl = getDecl();
     return typeDecl ? typeDecl->getDestructor() : nullptr;
@@ -16,6 +16,7 @@ namespace cx {
 
 struct ParamDecl;
 struct TypeDecl;
+struct FunctionDecl;
 struct DestructorDecl;
 struct TupleElement;
 
@@ -65,6 +66,7 @@ struct Type {
     bool isOptionalType() const { return isBasicType() && getName() == "Optional"; }
     bool isBuiltinType() const { return (isBasicType() && isBuiltinScalar(getName())) || isPointerType() || isNull() || isVoid(); }
     bool isImplicitlyCopyable() const;
+    bool isTriviallyRelocatable() const;
     bool isConstantArray() const;
     bool isArrayRef() const;
     bool isUnsizedArrayPointer() const;
@@ -112,6 +114,8 @@ struct Type {
     Type removeOptional() const { return isOptionalType() ? getWrappedType() : *this; }
     TypeKind getKind() const { return typeBase->getKind(); }
     TypeDecl* getDecl() const;
+    /// Returns the lambda called through values of this type if this is a closure type, otherwise null.
+    FunctionDecl* getClosureFunction() const;
     DestructorDecl* getDestructor() const;
     bool equalsIgnoreTopLevelMutable(Type) const;
     bool containsUnresolvedPlaceholder() const;
@@ -30,7 +30,7 @@ void CGenerator::codegenModule(const IRModule& module) {
         codegenGlobalVariable(globalVariable);
     }
     for (auto* function : module.functions) {
-        if (function->isExtern) continue;
+        if (function->isExtern || function->body.empty()) continue; // Defined in the module that owns the function.
         if (alreadyDefinedFunctions.contains(function->mangledName)) continue;
         alreadyDefinedFunctions.insert(function->mangledName);
         codegenFunction(function);
@@ -41,11 +41,10 @@ void CGenerator::codegenAlloca(const AllocaInst* inst) {
     stream.indent(4);
     codegenType(stream, inst->allocatedType, true);
     stream << ' ';
-    auto name = (!inst->name.empty() ? inst->name : "_alloca") + std::to_string(valueSuffixCounter++);
-    stream << name;
+    codegenValueName(inst);
     codegenTypeSuffix(stream, inst->allocatedType, true);
     stream << ";\n";
-    emittedValues.insert({inst, "(&" + std::move(name) + ")"});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenReturn(const ReturnInst* inst) {
@@ -64,7 +63,9 @@ void CGenerator::codegenBranch(const BranchInst* inst) {
         codegenInst(inst->argument);
         stream << "; // branch argument\n";
     }
-    stream.indent(4) << "goto " << getBlockLabel(inst->destination) << ";\n";
+    stream.indent(4) << "goto ";
+    codegenBlockLabel(inst->destination);
+    stream << ";\n";
 }
 
 void CGenerator::codegenCondBranch(const CondBranchInst* inst) {
@@ -86,14 +87,18 @@ void CGenerator::codegenCondBranch(const CondBranchInst* inst) {
         codegenInst(inst->argument);
         stream << ";\n";
     }
-    stream.indent(8) << "goto " << getBlockLabel(inst->trueBlock) << ";\n";
+    stream.indent(8) << "goto ";
+    codegenBlockLabel(inst->trueBlock);
+    stream << ";\n";
     stream.indent(4) << "} else {\n";
     if (inst->falseBlock->parameter) {
         stream.indent(8) << inst->falseBlock->parameter->name << " = ";
         codegenInst(inst->argument);
         stream << ";\n";
     }
-    stream.indent(8) << "goto " << getBlockLabel(inst->falseBlock) << ";\n";
+    stream.indent(8) << "goto ";
+    codegenBlockLabel(inst->falseBlock);
+    stream << ";\n";
     stream.indent(4) << "}\n";
 }
 
@@ -105,19 +110,25 @@ void CGenerator::codegenSwitch(const SwitchInst* inst) {
         stream.indent(8);
         stream << "case ";
         codegenInst(value);
-        stream << ": goto " << getBlockLabel(block) << ";\n";
+        stream << ": goto ";
+        codegenBlockLabel(block);
+        stream << ";\n";
     }
-    // TODO: handle inst->defaultBlock
+    // Emitting the cases as a single C switch lets the C compiler choose between a jump table and a binary search.
+    stream.indent(8) << "default: goto ";
+    codegenBlockLabel(inst->defaultBlock);
+    stream << ";\n";
     stream.indent(4) << "}\n";
 }
 
 void CGenerator::codegenLoad(const LoadInst* inst) {
     stream.indent(4);
-    auto name = "_load" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = *";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = *";
     codegenInst(inst->value);
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenStore(const StoreInst* inst) {
@@ -144,16 +155,20 @@ void CGenerator::codegenInsert(const InsertInst* inst) {
     auto type = inst->aggregate->getType();
     ASSERT(type->isStruct() || type->isArrayType());
     codegenType(stream, type, true);
-    auto name = "_insert" + std::to_string(valueSuffixCounter++);
-    stream << " " << name;
+    stream << " ";
+    codegenValueName(inst);
     codegenTypeSuffix(stream, type, true);
     stream << "; ";
     if (inst->aggregate->kind != ValueKind::Undefined) {
-        stream << "memcpy(&" << name << ", &";
+        stream << "memcpy(&";
+        codegenValueName(inst);
+        stream << ", &";
         codegenInst(inst->aggregate);
-        stream << ", sizeof(" << name << ")); ";
+        stream << ", sizeof(";
+        codegenValueName(inst);
+        stream << ")); ";
     }
-    stream << name;
+    codegenValueName(inst);
     if (type->isArrayType()) {
         stream << "[" << inst->index << "] = ";
     } else {
@@ -161,28 +176,28 @@ void CGenerator::codegenInsert(const InsertInst* inst) {
     }
     codegenInst(inst->value);
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenExtract(const ExtractInst* inst) {
     stream.indent(4);
-    auto name = "_extract" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = ";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = ";
     codegenInst(inst->aggregate);
     stream << "." << inst->name;
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenCall(const CallInst* inst) {
     stream.indent(4);
     auto returnType = inst->function->getType()->getPointee()->getReturnType();
-    std::string name;
     bool hasReturnValue = !returnType->isVoid() && !returnType->isNever();
     if (hasReturnValue) {
-        name = "_call" + std::to_string(valueSuffixCounter++);
         codegenType(stream, returnType, true);
-        stream << " " << name;
+        stream << " ";
+        codegenValueName(inst);
         codegenTypeSuffix(stream, returnType, true);
         stream << " = ";
     }
@@ -194,14 +209,15 @@ void CGenerator::codegenCall(const CallInst* inst) {
     }
     stream << ");\n";
     if (hasReturnValue) {
-        emittedValues.insert({inst, std::move(name)});
+        setEmitted(inst);
     }
 }
 
 void CGenerator::codegenBinary(const BinaryInst* inst) {
     stream.indent(4);
-    auto name = "_binary_op" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = ";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = ";
     codegenInst(inst->left);
     stream << ' ';
     switch (inst->op.getKind()) {
@@ -259,13 +275,14 @@ void CGenerator::codegenBinary(const BinaryInst* inst) {
     stream << ' ';
     codegenInst(inst->right);
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenUnary(const UnaryInst* inst) {
     stream.indent(4);
-    auto name = "_unary_op" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = ";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = ";
     switch (inst->op.getKind()) {
     case Token::Plus:
         stream << '+';
@@ -284,14 +301,15 @@ void CGenerator::codegenUnary(const UnaryInst* inst) {
     }
     codegenInst(inst->operand);
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenGEP(const GEPInst* inst) {
     stream.indent(4);
-    auto name = "_get_element_ptr" + std::to_string(valueSuffixCounter++);
     codegenType(stream, inst->getType(), true);
-    stream << " " << name << " = ";
+    stream << " ";
+    codegenValueName(inst);
+    stream << " = ";
     for (auto* index : inst->indexes) {
         (void)index;
         stream << "&(";
@@ -303,28 +321,101 @@ void CGenerator::codegenGEP(const GEPInst* inst) {
         stream << ']';
     }
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenConstGEP(const ConstGEPInst* inst) {
     stream.indent(4);
-    auto name = "_const_get_element_ptr" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = &";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = &";
     codegenInst(inst->pointer);
     stream << "->" << inst->name << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
 }
 
 void CGenerator::codegenCast(const CastInst* inst) {
     stream.indent(4);
-    auto name = "_cast" + std::to_string(valueSuffixCounter++);
-    stream << "__auto_type " << name << " = ";
+    stream << "__auto_type ";
+    codegenValueName(inst);
+    stream << " = ";
     stream << "(";
     codegenType(stream, inst->type, true);
+    codegenTypeSuffix(stream, inst->type, true);
     stream << ") ";
     codegenInst(inst->value);
     stream << ";\n";
-    emittedValues.insert({inst, std::move(name)});
+    setEmitted(inst);
+}
+
+void CGenerator::codegenAtomic(const AtomicInst* inst) {
+    stream.indent(4);
+
+    if (inst->op == AtomicOperation::CompareExchange) {
+        // The expected value is passed by pointer, so it's stored in a variable named after the result.
+        stream << "__auto_type _expected";
+        codegenValueName(inst);
+        stream << " = ";
+        codegenInst(inst->value);
+        stream << "; ";
+        stream << "_Bool ";
+        codegenValueName(inst);
+        stream << " = __atomic_compare_exchange_n(";
+        codegenInst(inst->pointer);
+        stream << ", &_expected";
+        codegenValueName(inst);
+        stream << ", ";
+        codegenInst(inst->desired);
+        stream << ", false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);\n";
+        setEmitted(inst);
+        return;
+    }
+
+    if (inst->op != AtomicOperation::Store) {
+        stream << "__auto_type ";
+        codegenValueName(inst);
+        stream << " = ";
+    }
+
+    switch (inst->op) {
+    case AtomicOperation::Load:
+        stream << "__atomic_load_n(";
+        break;
+    case AtomicOperation::Store:
+        stream << "__atomic_store_n(";
+        break;
+    case AtomicOperation::Exchange:
+        stream << "__atomic_exchange_n(";
+        break;
+    case AtomicOperation::Add:
+        stream << "__atomic_fetch_add(";
+        break;
+    case AtomicOperation::Subtract:
+        stream << "__atomic_fetch_sub(";
+        break;
+    case AtomicOperation::And:
+        stream << "__atomic_fetch_and(";
+        break;
+    case AtomicOperation::Or:
+        stream << "__atomic_fetch_or(";
+        break;
+    case AtomicOperation::Xor:
+        stream << "__atomic_fetch_xor(";
+        break;
+    case AtomicOperation::CompareExchange:
+        llvm_unreachable("handled above");
+    }
+
+    codegenInst(inst->pointer);
+    if (inst->value) {
+        stream << ", ";
+        codegenInst(inst->value);
+    }
+    stream << ", __ATOMIC_SEQ_CST);\n";
+
+    if (inst->op != AtomicOperation::Store) {
+        setEmitted(inst);
+    }
 }
 
 void CGenerator::codegenUnreachable() {
@@ -340,19 +431,23 @@ void CGenerator::codegenSizeof(const SizeofInst* inst) {
 void CGenerator::codegenBasicBlock(const BasicBlock* block) {
     if (!block->name.empty()) {
         // Extra semicolon to work around "label followed by a declaration is a C23 extension".
-        stream << '\n' << getBlockLabel(block) << ": ;\n";
+        stream << '\n';
+        codegenBlockLabel(block);
+        stream << ": ;\n";
     }
     for (auto* inst : block->body) {
+        codegenLineDirective(inst->location);
         codegenInst(inst);
     }
 }
 
 void CGenerator::codegenGlobalVariable(const GlobalVariable* inst) {
+    if (inst->isThreadLocal) stream << "_Thread_local ";
     codegenType(stream, inst->type, true);
     stream << ' ' << inst->name;
     codegenTypeSuffix(stream, inst->type, true);
     stream << ";\n";
-    emittedValues.insert({inst, "(&" + inst->name + ")"});
+    emittedGlobals.insert(inst);
 }
 
 void CGenerator::codegenConstantString(const ConstantString* inst) {
@@ -383,23 +478,53 @@ void CGenerator::codegenUndefined(const Undefined*) {
     llvm_unreachable("undefined instructions should be handled in parent instruction");
 }
 
-const std::string& CGenerator::getBlockLabel(const BasicBlock* block) {
-    auto it = emittedValues.find(block);
-    if (it != emittedValues.end()) {
-        return it->second;
+void CGenerator::codegenBlockLabel(const BasicBlock* block) {
+    for (char c : block->name) {
+        stream << (c == '.' ? '_' : c);
+    }
+    stream << '_' << block->index;
+}
+
+/// Values are named by their index in the function, so that names don't need to be built and stored. Allocas keep the
+/// name of their variable after the index, to make the generated code easier to read.
+void CGenerator::codegenValueName(const Value* value) {
+    ASSERT(value->index != Value::noIndex);
+    if (auto* alloca = llvm::dyn_cast<AllocaInst>(value)) {
+        stream << '_' << value->index << '_' << alloca->name;
     } else {
-        auto name = block->name;
-        llvm::replace(name, '.', '_');
-        llvm::raw_string_ostream os(name);
-        os << valueSuffixCounter++;
-        return emittedValues.insert({block, std::move(os.str())}).first->second;
+        stream << "_v" << value->index;
     }
 }
 
+/// Emits a #line directive for the next line of C code. Each instruction is emitted on its own line, so every
+/// instruction gets a directive rather than only those that start a new source line.
+void CGenerator::codegenLineDirective(Location location) {
+    if (!emitLineDirectives || !location.isValid() || !location.file) return;
+    stream << "#line " << location.line << " \"";
+    stream.write_escaped(location.file);
+    stream << "\"\n";
+}
+
+bool CGenerator::isEmitted(const Value* value) const {
+    return value->index < emittedValues.size() && emittedValues[value->index];
+}
+
+void CGenerator::setEmitted(const Value* value) {
+    ASSERT(value->index < emittedValues.size());
+    emittedValues[value->index] = true;
+}
+
 void CGenerator::codegenInst(const Value* value) {
-    auto it = emittedValues.find(value);
-    if (it != emittedValues.end()) {
-        stream << it->second;
+    if (isEmitted(value)) {
+        if (value->kind == ValueKind::AllocaInst) {
+            stream << "(&";
+            codegenValueName(value);
+            stream << ')';
+        } else {
+            codegenValueName(value);
+        }
+    } else if (auto* globalVariable = llvm::dyn_cast<GlobalVariable>(value); globalVariable && emittedGlobals.contains(globalVariable)) {
+        stream << "(&" << globalVariable->name << ')';
     } else {
         codegenInstImpl(value);
     }
@@ -437,6 +562,8 @@ void CGenerator::codegenInstImpl(const Value* value) {
         return codegenConstGEP(llvm::cast<ConstGEPInst>(value));
     case ValueKind::CastInst:
         return codegenCast(llvm::cast<CastInst>(value));
+    case ValueKind::AtomicInst:
+        return codegenAtomic(llvm::cast<AtomicInst>(value));
     case ValueKind::UnreachableInst:
         return codegenUnreachable();
     case ValueKind::SizeofInst:
@@ -484,12 +611,13 @@ void CGenerator::codegenFunctionPrototype(const Function* function) {
 
 void CGenerator::codegenFunction(const Function* function) {
     stream << '\n';
+    if (!function->isExtern) codegenLineDirective(function->location);
     codegenFunctionPrototype(function);
     if (function->isExtern) {
         stream << ';';
     } else {
         stream << " {\n";
-        valueSuffixCounter = 0;
+        emittedValues.assign(function->valueCount, false);
         for (auto* block : function->body) {
             codegenBasicBlock(block);
         }
@@ -647,6 +775,7 @@ std::string CGenerator::finish() {
            "#include <stdint.h>\n"
            "#include <stdlib.h>\n"
            "#include <string.h>\n"
+           "#include <time.h>\n"
            "#include <stdbool.h>\n"
          + preludeStream.str() + stream.str();
 }
@@ -2,11 +2,12 @@
 
 #include "ir.h"
 #include <unordered_set>
+#include <vector>
 
 namespace cx {
 
 struct CGenerator {
-    CGenerator() : preludeStream(prelude), stream(result) {}
+    CGenerator(bool emitLineDirectives = false) : preludeStream(prelude), stream(result), emitLineDirectives(emitLineDirectives) {}
     void codegenModule(const IRModule& module);
     void codegenAlloca(const AllocaInst* inst);
     void codegenReturn(const ReturnInst* inst);
@@ -23,6 +24,7 @@ struct CGenerator {
     void codegenGEP(const GEPInst* inst);
     void codegenConstGEP(const ConstGEPInst* inst);
     void codegenCast(const CastInst* inst);
+    void codegenAtomic(const AtomicInst* inst);
     void codegenUnreachable();
     void codegenSizeof(const SizeofInst* inst);
     void codegenBasicBlock(const BasicBlock* block);
@@ -40,7 +42,11 @@ struct CGenerator {
     void codegenType(llvm::raw_string_ostream& stream, IRType* type, bool needsTypeDefinition);
     void codegenTypeSuffix(llvm::raw_string_ostream& stream, IRType* type, bool needsTypeDefinition);
     void codegenTypeDefinition(llvm::raw_string_ostream& stream, IRType* type);
-    const std::string& getBlockLabel(const BasicBlock* block);
+    void codegenBlockLabel(const BasicBlock* block);
+    void codegenValueName(const Value* value);
+    void codegenLineDirective(Location location);
+    bool isEmitted(const Value* value) const;
+    void setEmitted(const Value* value);
     std::string finish();
 
     std::string prelude;
@@ -49,8 +55,11 @@ struct CGenerator {
     llvm::raw_string_ostream stream; // Contains functions
     std::unordered_set<IRType*> alreadyEmittedTypes;
     std::unordered_set<std::string> alreadyDefinedFunctions;
-    std::unordered_map<const Value*, std::string> emittedValues;
-    int valueSuffixCounter = 0;
+    /// Whether each value of the current function, indexed by Value::index, has been assigned to a C variable.
+    std::vector<bool> emittedValues;
+    std::unordered_set<const GlobalVariable*> emittedGlobals;
+    /// Whether to map the generated code back to the Cx source with #line directives, for debuggers and profilers.
+    bool emitLineDirectives;
 };
 
 } // namespace cx
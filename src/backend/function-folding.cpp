@@ -0,0 +1,514 @@
+#include "function-folding.h"
+#pragma warning(push, 0)
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#pragma warning(pop)
+#include "ir.h"
+
+using namespace cx;
+
+/// Returns true if values of the given types have the same size, alignment, and representation. Pointers are all
+/// considered equivalent, since the functions being compared only differ in what the pointers are used to access if
+/// some instruction loads, stores, or indexes through them, and those instructions compare their own types.
+static bool isLayoutEquivalent(IRType* a, IRType* b) {
+    if (a == b) return true;
+    if (a->kind != b->kind) return false;
+
+    switch (a->kind) {
+    case IRTypeKind::IRBasicType:
+        return a->getName() == b->getName();
+    case IRTypeKind::IRPointerType:
+        return true;
+    case IRTypeKind::IRFunctionType:
+        if (llvm::cast<IRFunctionType>(a)->isVariadic != llvm::cast<IRFunctionType>(b)->isVariadic) return false;
+        if (!isLayoutEquivalent(a->getReturnType(), b->getReturnType())) return false;
+        if (a->getParamTypes().size() != b->getParamTypes().size()) return false;
+        for (size_t i = 0; i < a->getParamTypes().size(); ++i) {
+            if (!isLayoutEquivalent(a->getParamTypes()[i], b->getParamTypes()[i])) return false;
+        }
+        return true;
+    case IRTypeKind::IRArrayType:
+        return a->getArraySize() == b->getArraySize() && isLayoutEquivalent(a->getElementType(), b->getElementType());
+    case IRTypeKind::IRStructType:
+        if (llvm::cast<IRStructType>(a)->packed != llvm::cast<IRStructType>(b)->packed) return false;
+        [[fallthrough]];
+    case IRTypeKind::IRUnionType:
+        if (a->getFields().size() != b->getFields().size()) return false;
+        for (size_t i = 0; i < a->getFields().size(); ++i) {
+            if (!isLayoutEquivalent(a->getFields()[i].type, b->getFields()[i].type)) return false;
+        }
+        return true;
+    }
+
+    llvm_unreachable("all cases handled");
+}
+
+/// Folded functions are called through the canonical function, so their signatures must be ABI-compatible with it.
+/// Struct parameters are passed by value, so they must be the same type for the C backend to accept the call.
+static bool hasCompatibleSignatures(const Function* a, const Function* b) {
+    auto isCompatible = [](IRType* x, IRType* y) { return x->equals(y) || (x->isPointerType() && y->isPointerType()); };
+
+    if (!isCompatible(a->returnType, b->returnType)) return false;
+    if (a->params.size() != b->params.size()) return false;
+    for (size_t i = 0; i < a->params.size(); ++i) {
+        if (!isCompatible(a->params[i].type, b->params[i].type)) return false;
+    }
+    return true;
+}
+
+/// Calls 'callback' for each operand of 'inst' except the callee of a call instruction.
+template<typename Callback> static void forEachOperand(const Instruction* inst, Callback callback) {
+    switch (inst->kind) {
+    case ValueKind::ReturnInst:
+        if (auto* value = llvm::cast<ReturnInst>(inst)->value) callback(value);
+        break;
+    case ValueKind::BranchInst:
+        if (auto* argument = llvm::cast<BranchInst>(inst)->argument) callback(argument);
+        break;
+    case ValueKind::CondBranchInst: {
+        auto* condBranch = llvm::cast<CondBranchInst>(inst);
+        callback(condBranch->condition);
+        if (condBranch->argument) callback(condBranch->argument);
+        break;
+    }
+    case ValueKind::SwitchInst: {
+        auto* switchInst = llvm::cast<SwitchInst>(inst);
+        callback(switchInst->condition);
+        for (auto& switchCase : switchInst->cases) {
+            callback(switchCase.first);
+        }
+        break;
+    }
+    case ValueKind::LoadInst:
+        callback(llvm::cast<LoadInst>(inst)->value);
+        break;
+    case ValueKind::StoreInst:
+        callback(llvm::cast<StoreInst>(inst)->value);
+        callback(llvm::cast<StoreInst>(inst)->pointer);
+        break;
+    case ValueKind::InsertInst:
+        callback(llvm::cast<InsertInst>(inst)->aggregate);
+        callback(llvm::cast<InsertInst>(inst)->value);
+        break;
+    case ValueKind::ExtractInst:
+        callback(llvm::cast<ExtractInst>(inst)->aggregate);
+        break;
+    case ValueKind::CallInst:
+        for (auto* arg : llvm::cast<CallInst>(inst)->args) {
+            callback(arg);
+        }
+        break;
+    case ValueKind::BinaryInst:
+        callback(llvm::cast<BinaryInst>(inst)->left);
+        callback(llvm::cast<BinaryInst>(inst)->right);
+        break;
+    case ValueKind::UnaryInst:
+        callback(llvm::cast<UnaryInst>(inst)->operand);
+        break;
+    case ValueKind::GEPInst:
+        callback(llvm::cast<GEPInst>(inst)->pointer);
+        for (auto* index : llvm::cast<GEPInst>(inst)->indexes) {
+            callback(index);
+        }
+        break;
+    case ValueKind::ConstGEPInst:
+        callback(llvm::cast<ConstGEPInst>(inst)->pointer);
+        break;
+    case ValueKind::CastInst:
+        callback(llvm::cast<CastInst>(inst)->value);
+        break;
+    case ValueKind::AtomicInst: {
+        auto* atomic = llvm::cast<AtomicInst>(inst);
+        callback(atomic->pointer);
+        if (atomic->value) callback(atomic->value);
+        if (atomic->desired) callback(atomic->desired);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static bool producesValue(const Instruction* inst) {
+    switch (inst->kind) {
+    case ValueKind::ReturnInst:
+    case ValueKind::BranchInst:
+    case ValueKind::CondBranchInst:
+    case ValueKind::SwitchInst:
+    case ValueKind::StoreInst:
+    case ValueKind::UnreachableInst:
+        return false;
+    case ValueKind::AtomicInst:
+        return llvm::cast<AtomicInst>(inst)->op != AtomicOperation::Store;
+    default:
+        return true;
+    }
+}
+
+static size_t hashFunctionBody(const Function* function) {
+    auto hash = llvm::hash_combine(function->params.size(), function->returnType->kind, function->body.size());
+
+    for (auto* block : function->body) {
+        hash = llvm::hash_combine(hash, block->body.size(), block->parameter != nullptr);
+
+        for (auto* inst : block->body) {
+            hash = llvm::hash_combine(hash, inst->kind);
+
+            switch (inst->kind) {
+            case ValueKind::BinaryInst:
+                hash = llvm::hash_combine(hash, llvm::cast<BinaryInst>(inst)->op.getKind());
+                break;
+            case ValueKind::UnaryInst:
+                hash = llvm::hash_combine(hash, llvm::cast<UnaryInst>(inst)->op.getKind());
+                break;
+            case ValueKind::ConstGEPInst:
+                hash = llvm::hash_combine(hash, llvm::cast<ConstGEPInst>(inst)->index);
+                break;
+            case ValueKind::ExtractInst:
+                hash = llvm::hash_combine(hash, llvm::cast<ExtractInst>(inst)->index);
+                break;
+            case ValueKind::CallInst:
+                hash = llvm::hash_combine(hash, llvm::cast<CallInst>(inst)->args.size());
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    return hash;
+}
+
+int FunctionFolder::fold(llvm::ArrayRef<IRModule*> modules) {
+    collectCandidates(modules);
+    if (candidates.size() < 2) return 0;
+
+    // Start from the coarsest partition where callees are assumed equivalent, then split classes until the members of
+    // each class call equivalent functions. This also folds mutually recursive functions.
+    partition(false);
+    while (partition(true)) {}
+
+    llvm::StringMap<Function*> replacements;
+    for (auto& candidate : candidates) {
+        auto* canonical = candidates[candidate.classId].function;
+        if (canonical != candidate.function) {
+            replacements.try_emplace(candidate.function->mangledName, canonical);
+        }
+    }
+
+    if (!replacements.empty()) {
+        redirectCalls(modules, replacements);
+    }
+
+    return int(replacements.size());
+}
+
+void FunctionFolder::collectCandidates(llvm::ArrayRef<IRModule*> modules) {
+    // Functions whose address is taken must keep a unique address, so only functions that are exclusively called are folded.
+    auto markAddressTaken = [&](const Value* value) {
+        if (auto* function = llvm::dyn_cast<Function>(value)) {
+            addressTakenFunctions.insert(function->mangledName);
+        }
+    };
+
+    for (auto* module : modules) {
+        for (auto* globalVariable : module->globalVariables) {
+            if (globalVariable->value) markAddressTaken(globalVariable->value);
+        }
+        for (auto* function : module->functions) {
+            for (auto* block : function->body) {
+                for (auto* inst : block->body) {
+                    forEachOperand(inst, markAddressTaken);
+                }
+            }
+        }
+    }
+
+    llvm::DenseMap<size_t, int> classIdsByHash;
+
+    for (auto* module : modules) {
+        for (auto* function : module->functions) {
+            if (function->isExtern || function->isVariadic || function->body.empty() || function->mangledName == "main") continue;
+            if (addressTakenFunctions.contains(function->mangledName)) continue;
+            if (!candidateIndexes.try_emplace(function->mangledName, int(candidates.size())).second) continue;
+
+            Candidate candidate{function, {}, hashFunctionBody(function), int(candidates.size())};
+            int number = 0;
+            for (auto& param : function->params) {
+                candidate.valueNumbers.try_emplace(&param, number++);
+            }
+            for (auto* block : function->body) {
+                candidate.valueNumbers.try_emplace(block, number++);
+                if (block->parameter) candidate.valueNumbers.try_emplace(block->parameter, number++);
+                for (auto* inst : block->body) {
+                    candidate.valueNumbers.try_emplace(inst, number++);
+                }
+            }
+
+            candidate.classId = classIdsByHash.try_emplace(candidate.hash, candidate.classId).first->second;
+            candidates.push_back(std::move(candidate));
+        }
+    }
+}
+
+/// Splits each class into subclasses whose members are equivalent to the subclass's first member. Class ids are the
+/// index of the first member, so the canonical function of a class is the one defined in the earliest module.
+/// Returns true if any class was split.
+bool FunctionFolder::partition(bool compareCallees) {
+    llvm::DenseMap<int, llvm::SmallVector<int, 2>> leadersByClassId;
+    std::vector<int> newClassIds(candidates.size());
+    bool changed = false;
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        auto& leaders = leadersByClassId[candidates[i].classId];
+        auto leader = llvm::find_if(leaders, [&](int leader) { return isEquivalent(candidates[leader], candidates[i], compareCallees); });
+
+        if (leader != leaders.end()) {
+            newClassIds[i] = *leader;
+        } else {
+            if (!leaders.empty()) changed = true;
+            leaders.push_back(int(i));
+            newClassIds[i] = int(i);
+        }
+    }
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        candidates[i].classId = newClassIds[i];
+    }
+    return changed;
+}
+
+bool FunctionFolder::isEquivalent(const Candidate& a, const Candidate& b, bool compareCallees) const {
+    if (&a == &b) return true;
+    if (a.hash != b.hash) return false;
+
+    auto* f = a.function;
+    auto* g = b.function;
+    if (!hasCompatibleSignatures(f, g)) return false;
+    if (f->body.size() != g->body.size()) return false;
+
+    for (size_t i = 0; i < f->body.size(); ++i) {
+        auto* x = f->body[i];
+        auto* y = g->body[i];
+        if (x->body.size() != y->body.size()) return false;
+        if ((x->parameter == nullptr) != (y->parameter == nullptr)) return false;
+        if (x->parameter && !isLayoutEquivalent(x->parameter->type, y->parameter->type)) return false;
+
+        for (size_t j = 0; j < x->body.size(); ++j) {
+            if (!isEquivalent(a, x->body[j], b, y->body[j], compareCallees)) return false;
+        }
+    }
+
+    return true;
+}
+
+bool FunctionFolder::isEquivalent(const Candidate& a, const Instruction* x, const Candidate& b, const Instruction* y, bool compareCallees) const {
+    if (x->kind != y->kind) return false;
+    if (producesValue(x) && !isLayoutEquivalent(x->getType(), y->getType())) return false;
+
+    auto operand = [&](const Value* xOperand, const Value* yOperand) { return isEquivalentOperand(a, xOperand, b, yOperand, compareCallees); };
+    auto pointee = [](const Value* pointer) { return pointer->getType()->getPointee(); };
+
+    switch (x->kind) {
+    case ValueKind::AllocaInst:
+        return isLayoutEquivalent(llvm::cast<AllocaInst>(x)->allocatedType, llvm::cast<AllocaInst>(y)->allocatedType);
+    case ValueKind::ReturnInst:
+        return operand(llvm::cast<ReturnInst>(x)->value, llvm::cast<ReturnInst>(y)->value);
+    case ValueKind::BranchInst: {
+        auto* xBranch = llvm::cast<BranchInst>(x);
+        auto* yBranch = llvm::cast<BranchInst>(y);
+        return operand(xBranch->destination, yBranch->destination) && operand(xBranch->argument, yBranch->argument);
+    }
+    case ValueKind::CondBranchInst: {
+        auto* xBranch = llvm::cast<CondBranchInst>(x);
+        auto* yBranch = llvm::cast<CondBranchInst>(y);
+        return operand(xBranch->condition, yBranch->condition) && operand(xBranch->trueBlock, yBranch->trueBlock)
+               && operand(xBranch->falseBlock, yBranch->falseBlock) && operand(xBranch->argument, yBranch->argument);
+    }
+    case ValueKind::SwitchInst: {
+        auto* xSwitch = llvm::cast<SwitchInst>(x);
+        auto* ySwitch = llvm::cast<SwitchInst>(y);
+        if (!operand(xSwitch->condition, ySwitch->condition) || !operand(xSwitch->defaultBlock, ySwitch->defaultBlock)) return false;
+        if (xSwitch->cases.size() != ySwitch->cases.size()) return false;
+        for (size_t i = 0; i < xSwitch->cases.size(); ++i) {
+            if (!operand(xSwitch->cases[i].first, ySwitch->cases[i].first)) return false;
+            if (!operand(xSwitch->cases[i].second, ySwitch->cases[i].second)) return false;
+        }
+        return true;
+    }
+    case ValueKind::LoadInst:
+        return operand(llvm::cast<LoadInst>(x)->value, llvm::cast<LoadInst>(y)->value);
+    case ValueKind::StoreInst: {
+        auto* xStore = llvm::cast<StoreInst>(x);
+        auto* yStore = llvm::cast<StoreInst>(y);
+        return operand(xStore->value, yStore->value) && operand(xStore->pointer, yStore->pointer)
+               && isLayoutEquivalent(xStore->value->getType(), yStore->value->getType());
+    }
+    case ValueKind::InsertInst: {
+        auto* xInsert = llvm::cast<InsertInst>(x);
+        auto* yInsert = llvm::cast<InsertInst>(y);
+        return xInsert->index == yInsert->index && operand(xInsert->aggregate, yInsert->aggregate) && operand(xInsert->value, yInsert->value);
+    }
+    case ValueKind::ExtractInst: {
+        auto* xExtract = llvm::cast<ExtractInst>(x);
+        auto* yExtract = llvm::cast<ExtractInst>(y);
+        return xExtract->index == yExtract->index && operand(xExtract->aggregate, yExtract->aggregate)
+               && isLayoutEquivalent(xExtract->aggregate->getType(), yExtract->aggregate->getType());
+    }
+    case ValueKind::CallInst: {
+        auto* xCall = llvm::cast<CallInst>(x);
+        auto* yCall = llvm::cast<CallInst>(y);
+        if (!operand(xCall->function, yCall->function)) return false;
+        if (xCall->args.size() != yCall->args.size()) return false;
+        for (size_t i = 0; i < xCall->args.size(); ++i) {
+            if (!operand(xCall->args[i], yCall->args[i])) return false;
+            if (!isLayoutEquivalent(xCall->args[i]->getType(), yCall->args[i]->getType())) return false;
+        }
+        return true;
+    }
+    case ValueKind::BinaryInst: {
+        auto* xBinary = llvm::cast<BinaryInst>(x);
+        auto* yBinary = llvm::cast<BinaryInst>(y);
+        return xBinary->op.getKind() == yBinary->op.getKind() && operand(xBinary->left, yBinary->left) && operand(xBinary->right, yBinary->right)
+               && isLayoutEquivalent(xBinary->left->getType(), yBinary->left->getType());
+    }
+    case ValueKind::UnaryInst: {
+        auto* xUnary = llvm::cast<UnaryInst>(x);
+        auto* yUnary = llvm::cast<UnaryInst>(y);
+        return xUnary->op.getKind() == yUnary->op.getKind() && operand(xUnary->operand, yUnary->operand)
+               && isLayoutEquivalent(xUnary->operand->getType(), yUnary->operand->getType());
+    }
+    case ValueKind::GEPInst: {
+        auto* xGEP = llvm::cast<GEPInst>(x);
+        auto* yGEP = llvm::cast<GEPInst>(y);
+        if (!operand(xGEP->pointer, yGEP->pointer) || !isLayoutEquivalent(pointee(xGEP->pointer), pointee(yGEP->pointer))) return false;
+        if (xGEP->indexes.size() != yGEP->indexes.size()) return false;
+        for (size_t i = 0; i < xGEP->indexes.size(); ++i) {
+            if (!operand(xGEP->indexes[i], yGEP->indexes[i])) return false;
+        }
+        return true;
+    }
+    case ValueKind::ConstGEPInst: {
+        auto* xGEP = llvm::cast<ConstGEPInst>(x);
+        auto* yGEP = llvm::cast<ConstGEPInst>(y);
+        return xGEP->index == yGEP->index && operand(xGEP->pointer, yGEP->pointer) && isLayoutEquivalent(pointee(xGEP->pointer), pointee(yGEP->pointer));
+    }
+    case ValueKind::CastInst: {
+        auto* xCast = llvm::cast<CastInst>(x);
+        auto* yCast = llvm::cast<CastInst>(y);
+        return operand(xCast->value, yCast->value) && isLayoutEquivalent(xCast->value->getType(), yCast->value->getType());
+    }
+    case ValueKind::AtomicInst: {
+        auto* xAtomic = llvm::cast<AtomicInst>(x);
+        auto* yAtomic = llvm::cast<AtomicInst>(y);
+        return xAtomic->op == yAtomic->op && operand(xAtomic->pointer, yAtomic->pointer) && operand(xAtomic->value, yAtomic->value)
+               && operand(xAtomic->desired, yAtomic->desired) && isLayoutEquivalent(pointee(xAtomic->pointer), pointee(yAtomic->pointer));
+    }
+    case ValueKind::UnreachableInst:
+        return true;
+    case ValueKind::SizeofInst:
+        return isLayoutEquivalent(llvm::cast<SizeofInst>(x)->type, llvm::cast<SizeofInst>(y)->type);
+    default:
+        llvm_unreachable("unknown instruction kind");
+    }
+}
+
+bool FunctionFolder::isEquivalentOperand(const Candidate& a, const Value* x, const Candidate& b, const Value* y, bool compareCallees) const {
+    if (!x || !y) return x == y;
+
+    // Values defined inside the functions must be at the same position.
+    auto xNumber = a.valueNumbers.find(x);
+    auto yNumber = b.valueNumbers.find(y);
+    if (xNumber != a.valueNumbers.end() || yNumber != b.valueNumbers.end()) {
+        return xNumber != a.valueNumbers.end() && yNumber != b.valueNumbers.end() && xNumber->second == yNumber->second;
+    }
+
+    if (x->kind != y->kind) return false;
+
+    switch (x->kind) {
+    case ValueKind::Function: {
+        auto& xName = llvm::cast<Function>(x)->mangledName;
+        auto& yName = llvm::cast<Function>(y)->mangledName;
+        if (xName == yName) return true;
+
+        auto xIndex = candidateIndexes.find(xName);
+        auto yIndex = candidateIndexes.find(yName);
+        if (xIndex == candidateIndexes.end() || yIndex == candidateIndexes.end()) return false;
+        return !compareCallees || candidates[xIndex->second].classId == candidates[yIndex->second].classId;
+    }
+    case ValueKind::GlobalVariable:
+        return x == y || llvm::cast<GlobalVariable>(x)->name == llvm::cast<GlobalVariable>(y)->name;
+    case ValueKind::ConstantString:
+        return llvm::cast<ConstantString>(x)->value == llvm::cast<ConstantString>(y)->value;
+    case ValueKind::ConstantInt: {
+        auto* xInt = llvm::cast<ConstantInt>(x);
+        auto* yInt = llvm::cast<ConstantInt>(y);
+        return isLayoutEquivalent(xInt->type, yInt->type) && llvm::APSInt::isSameValue(xInt->value, yInt->value);
+    }
+    case ValueKind::ConstantFP: {
+        auto* xFP = llvm::cast<ConstantFP>(x);
+        auto* yFP = llvm::cast<ConstantFP>(y);
+        return isLayoutEquivalent(xFP->type, yFP->type) && xFP->value.bitwiseIsEqual(yFP->value);
+    }
+    case ValueKind::ConstantBool:
+        return llvm::cast<ConstantBool>(x)->value == llvm::cast<ConstantBool>(y)->value;
+    case ValueKind::ConstantNull:
+        return isLayoutEquivalent(llvm::cast<ConstantNull>(x)->type, llvm::cast<ConstantNull>(y)->type);
+    case ValueKind::Undefined:
+        return isLayoutEquivalent(llvm::cast<Undefined>(x)->type, llvm::cast<Undefined>(y)->type);
+    default:
+        return false;
+    }
+}
+
+/// Makes every call to a folded function call its canonical function instead, casting the canonical function to the
+/// folded function's type when their pointer parameter types differ, and removes the folded functions.
+void FunctionFolder::redirectCalls(llvm::ArrayRef<IRModule*> modules, const llvm::StringMap<Function*>& replacements) {
+    for (auto* module : modules) {
+        llvm::StringMap<Function*> functionsByName;
+        for (auto* function : module->functions) {
+            functionsByName.try_emplace(function->mangledName, function);
+        }
+
+        std::vector<Function*> newDeclarations;
+
+        for (auto* function : module->functions) {
+            for (auto* block : function->body) {
+                for (size_t i = 0; i < block->body.size(); ++i) {
+                    auto* call = llvm::dyn_cast<CallInst>(block->body[i]);
+                    if (!call) continue;
+                    auto* callee = llvm::dyn_cast<Function>(call->function);
+                    if (!callee) continue;
+                    auto replacement = replacements.find(callee->mangledName);
+                    if (replacement == replacements.end()) continue;
+
+                    auto* canonical = replacement->second;
+                    auto*& declaration = functionsByName[canonical->mangledName];
+                    if (!declaration) {
+                        declaration = new Function{
+                            ValueKind::Function, canonical->mangledName, canonical->returnType, canonical->params, {}, false, false,
+                        };
+                        declaration->location = canonical->location;
+                        newDeclarations.push_back(declaration);
+                    }
+
+                    auto* calleeType = callee->getType();
+                    if (declaration->getType()->equals(calleeType)) {
+                        call->function = declaration;
+                    } else {
+                        auto* cast = new CastInst{ValueKind::CastInst, declaration, calleeType, ""};
+                        cast->parent = block;
+                        function->addValue(cast);
+                        block->body.insert(block->body.begin() + i, cast);
+                        ++i;
+                        call->function = cast;
+                    }
+                }
+            }
+        }
+
+        llvm::erase_if(module->functions, [&](Function* function) { return replacements.count(function->mangledName) != 0; });
+        module->functions.insert(module->functions.end(), newDeclarations.begin(), newDeclarations.end());
+    }
+}
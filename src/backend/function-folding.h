@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#pragma warning(push, 0)
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
+#pragma warning(pop)
+
+namespace cx {
+
+struct IRModule;
+struct IRType;
+struct Function;
+struct Value;
+struct Instruction;
+
+/// Identical code folding over the generated IR modules: functions whose bodies are identical up to the names of the
+/// types they operate on (e.g. List<int*>.push and List<string*>.push) are merged into a single definition, and all
+/// calls to the folded functions are redirected to the remaining one.
+struct FunctionFolder {
+    struct Candidate {
+        Function* function;
+        /// Position of each parameter, block, block parameter, and instruction of the function, used to compare operands.
+        llvm::DenseMap<const Value*, int> valueNumbers;
+        size_t hash;
+        int classId;
+    };
+
+    /// Returns the number of functions that were folded away.
+    int fold(llvm::ArrayRef<IRModule*> modules);
+    void collectCandidates(llvm::ArrayRef<IRModule*> modules);
+    bool partition(bool compareCallees);
+    bool isEquivalent(const Candidate& a, const Candidate& b, bool compareCallees) const;
+    bool isEquivalent(const Candidate& a, const Instruction* x, const Candidate& b, const Instruction* y, bool compareCallees) const;
+    bool isEquivalentOperand(const Candidate& a, const Value* x, const Candidate& b, const Value* y, bool compareCallees) const;
+    void redirectCalls(llvm::ArrayRef<IRModule*> modules, const llvm::StringMap<Function*>& replacements);
+
+    std::vector<Candidate> candidates;
+    llvm::StringMap<int> candidateIndexes;
+    llvm::StringSet<> addressTakenFunctions;
+};
+
+} // namespace cx
@@ -16,6 +16,23 @@ BasicBlock::BasicBlock(std::string name, cx::Function* parent) : Value{ValueKind
     }
 }
 
+void Function::numberValues() {
+    valueCount = 0;
+
+    for (auto& param : params) {
+        addValue(&param);
+    }
+
+    for (auto* block : body) {
+        addValue(block);
+        if (block->parameter) addValue(block->parameter);
+
+        for (auto* inst : block->body) {
+            addValue(inst);
+        }
+    }
+}
+
 static std::unordered_map<TypeBase*, IRType*> irTypes = {{nullptr, nullptr}};
 
 IRType* cx::getIRType(Type astType) {
@@ -202,6 +219,17 @@ IRType* Value::getType() const {
     }
     case ValueKind::CastInst:
         return llvm::cast<CastInst>(this)->type;
+    case ValueKind::AtomicInst: {
+        auto atomic = llvm::cast<AtomicInst>(this);
+        switch (atomic->op) {
+        case AtomicOperation::Store:
+            llvm_unreachable("unhandled atomic store");
+        case AtomicOperation::CompareExchange:
+            return getIRType(Type::getBool());
+        default:
+            return atomic->pointer->getType()->getPointee();
+        }
+    }
     case ValueKind::UnreachableInst:
         llvm_unreachable("unhandled UnreachableInst");
     case ValueKind::SizeofInst:
@@ -287,6 +315,8 @@ std::string Value::getName() const {
         return llvm::cast<ConstGEPInst>(this)->name;
     case ValueKind::CastInst:
         return llvm::cast<CastInst>(this)->name;
+    case ValueKind::AtomicInst:
+        return llvm::cast<AtomicInst>(this)->name;
     case ValueKind::UnreachableInst:
         llvm_unreachable("unhandled UnreachableInst");
     case ValueKind::SizeofInst:
@@ -370,6 +400,30 @@ static std::string formatName(const Value* inst) {
     return std::move(s.str());
 }
 
+static const char* getAtomicOperationName(AtomicOperation op) {
+    switch (op) {
+    case AtomicOperation::Load:
+        return "load";
+    case AtomicOperation::Store:
+        return "store";
+    case AtomicOperation::Exchange:
+        return "xchg";
+    case AtomicOperation::Add:
+        return "add";
+    case AtomicOperation::Subtract:
+        return "sub";
+    case AtomicOperation::And:
+        return "and";
+    case AtomicOperation::Or:
+        return "or";
+    case AtomicOperation::Xor:
+        return "xor";
+    case AtomicOperation::CompareExchange:
+        return "cmpxchg";
+    }
+    llvm_unreachable("all cases handled");
+}
+
 static std::string formatTypeAndName(const Value* inst) {
     std::string str;
     llvm::raw_string_ostream s(str);
@@ -476,6 +530,15 @@ void Value::print(llvm::raw_ostream& stream) const {
         stream << indent << formatTypeAndName(cast) << " = cast " << formatName(cast->value) << " to " << cast->type;
         break;
     }
+    case ValueKind::AtomicInst: {
+        auto atomic = llvm::cast<AtomicInst>(this);
+        stream << indent;
+        if (atomic->op != AtomicOperation::Store) stream << formatTypeAndName(atomic) << " = ";
+        stream << "atomic " << getAtomicOperationName(atomic->op) << " " << formatName(atomic->pointer);
+        if (atomic->value) stream << ", " << formatName(atomic->value);
+        if (atomic->desired) stream << ", " << formatName(atomic->desired);
+        break;
+    }
     case ValueKind::UnreachableInst: {
         stream << indent << "unreachable";
         break;
@@ -528,6 +591,7 @@ void Value::print(llvm::raw_ostream& stream) const {
         break;
     case ValueKind::GlobalVariable: {
         auto globalVariable = llvm::cast<GlobalVariable>(this);
+        if (globalVariable->isThreadLocal) stream << "thread_local ";
         stream << "global " << formatName(globalVariable) << " = " << formatTypeAndName(globalVariable->value);
         break;
     }
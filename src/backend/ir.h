@@ -133,6 +133,7 @@ enum class ValueKind {
     GEPInst,
     ConstGEPInst,
     CastInst,
+    AtomicInst,
     UnreachableInst,
     SizeofInst,
     BasicBlock,
@@ -150,6 +151,14 @@ enum class ValueKind {
 struct Value {
     ValueKind kind;
     BasicBlock* parent = nullptr;
+    /// Dense index of the value within its function, so that the backends can map values through flat arrays instead of
+    /// hash maps. Assigned to parameters, basic blocks and instructions by Function::numberValues(). Constants, globals
+    /// and functions keep `noIndex`.
+    unsigned index = noIndex;
+    static const unsigned noIndex = ~0u;
+    /// Source location that the value was generated from, used for debug info. Instructions get the location of the
+    /// innermost expression or statement being emitted when they were created, functions the location of their decl.
+    Location location;
 
     Value(ValueKind kind) : kind(kind) {}
     IRType* getType() const;
@@ -288,6 +297,29 @@ struct CastInst : Instruction {
     static bool classof(const Value* v) { return v->kind == ValueKind::CastInst; }
 };
 
+enum class AtomicOperation {
+    Load,
+    Store,
+    Exchange,
+    Add,
+    Subtract,
+    And,
+    Or,
+    Xor,
+    CompareExchange,
+};
+
+/// A sequentially consistent atomic memory operation on the integer or pointer pointed to by 'pointer'.
+struct AtomicInst : Instruction {
+    AtomicOperation op;
+    Value* pointer;
+    Value* value; // Null for loads. For compare-exchange, this is the expected value.
+    Value* desired; // Only used for compare-exchange.
+    std::string name;
+
+    static bool classof(const Value* v) { return v->kind == ValueKind::AtomicInst; }
+};
+
 struct UnreachableInst : Instruction {
     static bool classof(const Value* v) { return v->kind == ValueKind::UnreachableInst; }
 };
@@ -329,8 +361,16 @@ struct Function : Value {
     std::vector<BasicBlock*> body;
     bool isExtern;
     bool isVariadic;
-    Location location;
-
+    /// Allocas created while the body is being generated. They're moved to the start of the entry block once the body
+    /// is complete, so that creating one doesn't need to search the entry block for the end of its allocas.
+    std::vector<AllocaInst*> pendingAllocas;
+    /// The number of values in the function that have been given an index.
+    unsigned valueCount = 0;
+
+    /// Gives each parameter, basic block, block parameter and instruction of the function a dense index.
+    void numberValues();
+    /// Gives a new value a dense index, after numberValues() has been called.
+    void addValue(Value* value) { value->index = valueCount++; }
     static bool classof(const Value* v) { return v->kind == ValueKind::Function; }
 };
 
@@ -338,6 +378,7 @@ struct GlobalVariable : Value {
     IRType* type;
     Value* value;
     std::string name;
+    bool isThreadLocal;
 
     static bool classof(const Value* v) { return v->kind == ValueKind::GlobalVariable; }
 };
@@ -3,42 +3,44 @@
 #include <llvm/Support/SaveAndRestore.h>
 #pragma warning(pop)
 #include "../ast/mangle.h"
+#include "../ast/module.h"
 
 using namespace cx;
 
 Function* IRGenerator::getFunction(const FunctionDecl& decl) {
     auto mangledName = mangleFunctionDecl(decl);
 
-    for (auto* function : module->functions) {
-        if (function->mangledName == mangledName) {
-            return function;
-        }
+    if (auto* function = moduleFunctions.lookup(mangledName)) {
+        return function;
     }
 
     auto params = map(decl.getParams(), [](const ParamDecl& p) { return Parameter{ValueKind::Parameter, getIRType(p.type), p.getName().str()}; });
 
     if (decl.isMethodDecl()) {
         params.insert(params.begin(), Parameter{ValueKind::Parameter, getIRType(decl.getTypeDecl()->getType().getPointerTo()), "this"});
+    } else if (decl.closureType) {
+        params.insert(params.begin(), Parameter{ValueKind::Parameter, getIRType(decl.closureType->getType()), "closure"});
     }
 
     auto returnType = getIRType(decl.isMain() ? Type::getInt() : decl.getReturnType());
     auto function = new Function{
-        ValueKind::Function, mangledName, returnType, std::move(params), {}, decl.isExtern(), decl.isVariadic(), decl.getLocation(),
+        ValueKind::Function, mangledName, returnType, std::move(params), {}, decl.isExtern(), decl.isVariadic(),
     };
+    function->location = decl.getLocation();
     module->functions.push_back(function);
+    moduleFunctions.try_emplace(mangledName, function);
 
-    for (auto& instantiation : functionInstantiations) {
-        if (instantiation.function->mangledName == mangledName) {
-            return function;
-        }
+    // The first module that references a function owns its definition, other modules only get a declaration.
+    if (functionOwners.try_emplace(mangledName, function).second) {
+        functionInstantiations.push_back({&decl, function});
     }
-
-    functionInstantiations.push_back({&decl, function});
     return function;
 }
 
 void IRGenerator::emitFunctionBody(const FunctionDecl& decl, Function& function) {
+    llvm::SaveAndRestore instrument(instrumentCurrentFunction, shouldInstrumentFunction(decl));
     currentFunction = &function;
+    currentLocation = function.location;
     setInsertPoint(new BasicBlock("", &function));
     beginScope();
 
@@ -46,6 +48,8 @@ void IRGenerator::emitFunctionBody(const FunctionDecl& decl, Function& function)
 
     if (decl.getTypeDecl()) {
         setLocalValue(&*arg++, nullptr);
+    } else if (decl.closureType) {
+        emitClosureCaptures(decl, &*arg++);
     }
 
     for (auto& param : decl.getParams()) {
@@ -59,22 +63,73 @@ void IRGenerator::emitFunctionBody(const FunctionDecl& decl, Function& function)
         }
     }
 
+    if (instrumentCurrentFunction) {
+        emitFunctionProfileHook("enterProfiledFunction", createGlobalStringPtr(decl.getQualifiedName()));
+    }
+
     emitStmts(*decl.body);
     endScope();
 
     if (insertBlock->body.empty() || !llvm::isa<ReturnInst>(insertBlock->body.back())) {
         if (decl.getReturnType().isVoid()) {
+            if (instrumentCurrentFunction) {
+                emitFunctionProfileHook("exitProfiledFunction", {});
+            }
             createReturn(decl.isMain() ? createConstantInt(Type::getInt(), 0) : nullptr);
         } else {
             createUnreachable();
         }
     }
+
+    auto* entryBlock = function.body.front();
+    for (auto* alloca : function.pendingAllocas) {
+        alloca->parent = entryBlock;
+    }
+    entryBlock->body.insert(entryBlock->body.begin(), function.pendingAllocas.begin(), function.pendingAllocas.end());
+    function.pendingAllocas.clear();
+    function.numberValues();
+}
+
+/// Returns whether the function should call the function profiler on entry and exit, when compiling with
+/// -finstrument-functions. The profiler's own hooks are never instrumented, to avoid infinite recursion.
+bool IRGenerator::shouldInstrumentFunction(const FunctionDecl& decl) const {
+    if (!options.instrumentFunctions) return false;
+
+    auto* stdlibModule = Module::getStdlibModule();
+    if (decl.getModule() == stdlibModule && (decl.getName() == "enterProfiledFunction" || decl.getName() == "exitProfiledFunction")) return false;
+
+    if (options.instrumentedFunctionPatterns.empty()) {
+        return decl.getModule() != stdlibModule;
+    }
+
+    auto name = decl.getQualifiedName();
+    return llvm::any_of(options.instrumentedFunctionPatterns, [&](const llvm::GlobPattern& pattern) { return pattern.match(name); });
+}
+
+/// Calls one of the function profiler hooks in std/FunctionProfile.cx.
+void IRGenerator::emitFunctionProfileHook(llvm::StringRef hookName, llvm::ArrayRef<Value*> args) {
+    auto* hookDecl = llvm::cast<FunctionDecl>(Module::getStdlibModule()->getSymbolTable().findOne(hookName));
+    createCall(getFunction(*hookDecl), args, nullptr);
+}
+
+/// Makes the variables captured by a lambda accessible in its body, through the pointers stored in its closure argument.
+void IRGenerator::emitClosureCaptures(const FunctionDecl& decl, Value* closure) {
+    for (size_t i = 0; i < decl.captures.size(); ++i) {
+        auto* capture = decl.captures[i];
+        auto* pointer = createExtractValue(closure, int(i), capture->getName());
+        // Captured variables are destroyed by the function that declares them, so no destructor call is deferred here.
+        addValue(capture, pointer, scopes.size() - 1);
+
+        if (capture->getName() == "this") {
+            addValue(nullptr, capture->type.isPointerType() ? createLoad(pointer) : pointer, scopes.size() - 1);
+        }
+    }
 }
 
 void IRGenerator::emitFunctionDecl(const FunctionDecl& decl) {
     auto function = getFunction(decl);
 
-    if (!decl.isExtern() && function->body.empty()) {
+    if (!decl.isExtern() && function->body.empty() && functionOwners.lookup(function->mangledName) == function) {
         emitFunctionBody(decl, *function);
     }
 }
@@ -92,11 +147,11 @@ Value* IRGenerator::emitVarDecl(const VarDecl& decl) {
         Value* value = decl.initializer ? emitExpr(*decl.initializer) : nullptr;
 
         if (decl.type.isMutable()) {
-            value = createGlobalVariable(value, decl.type, decl.getName());
+            value = createGlobalVariable(value, decl.type, decl.getName(), decl.isThreadLocal);
         }
 
-        auto it = globalScope().valuesByDecl.try_emplace(&decl, value);
-        ASSERT(it.second);
+        bool added = addValue(&decl, value, 0);
+        ASSERT(added);
         return value;
     } else {
         auto* alloca = createEntryBlockAlloca(decl.type, decl.getName());
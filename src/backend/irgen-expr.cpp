@@ -1,6 +1,8 @@
 #include "irgen.h"
 #pragma warning(push, 0)
+#include <llvm/ADT/StringSwitch.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/SaveAndRestore.h>
 #pragma warning(pop)
 #include "../ast/module.h"
 #include "../support/utility.h"
@@ -313,6 +315,11 @@ Value* IRGenerator::emitExprForPassing(const Expr& expr, IRType* targetType) {
     }
 }
 
+/// Returns e.g. "main.cx:12:5", as embedded in the generated code for assertion failure messages and allocation profiles.
+static std::string getLocationString(Location location) {
+    return llvm::join_items("", llvm::sys::path::filename(location.file), ":", std::to_string(location.line), ":", std::to_string(location.column));
+}
+
 void IRGenerator::emitAssert(Value* condition, const Expr* expr, Location location, llvm::StringRef message, const llvm::Twine& name) {
     condition = createIsNull(condition, expr, name + ".condition");
     auto* function = insertBlock->parent;
@@ -321,13 +328,22 @@ void IRGenerator::emitAssert(Value* condition, const Expr* expr, Location locati
     auto* assertFail = getFunction(*llvm::cast<FunctionDecl>(Module::getStdlibModule()->getSymbolTable().findOne("assertFail")));
     createCondBr(condition, failBlock, successBlock);
     setInsertPoint(failBlock);
-    auto messageAndLocation = llvm::join_items("", message, " at ", llvm::sys::path::filename(location.file), ":", std::to_string(location.line), ":",
-                                               std::to_string(location.column), "\n");
+    auto messageAndLocation = llvm::join_items("", message, " at ", getLocationString(location), "\n");
     createCall(assertFail, createGlobalStringPtr(messageAndLocation), nullptr);
     createUnreachable();
     setInsertPoint(successBlock);
 }
 
+/// Passes the location of a call from outside std into std to 'setAllocationSite', so that the allocation profile
+/// attributes the allocations made inside std, e.g. when a List grows, to the code that called it.
+void IRGenerator::emitAllocationSite(const CallExpr& expr) {
+    auto* stdlibModule = Module::getStdlibModule();
+    if (!currentDecl || currentDecl->getModule() == stdlibModule || expr.getCalleeDecl()->getModule() != stdlibModule) return;
+
+    auto* setAllocationSite = getFunction(*llvm::cast<FunctionDecl>(stdlibModule->getSymbolTable().findOne("setAllocationSite")));
+    createCall(setAllocationSite, createGlobalStringPtr(getLocationString(expr.getCallee().getLocation())), nullptr);
+}
+
 Value* IRGenerator::emitEnumCase(const EnumCase& enumCase, llvm::ArrayRef<NamedValue> associatedValueElements) {
     auto enumDecl = enumCase.getEnumDecl();
     auto tag = emitExpr(*enumCase.value);
@@ -360,6 +376,14 @@ Value* IRGenerator::emitCallExpr(const CallExpr& expr, AllocaInst* thisAllocaFor
         return emitBuiltinCast(expr);
     }
 
+    if (expr.isBuiltinAtomic()) {
+        return emitBuiltinAtomic(expr);
+    }
+
+    if (expr.isBuiltinTypeTrait()) {
+        return createConstantBool(expr.getGenericArgs().front().isTriviallyRelocatable());
+    }
+
     if (expr.getFunctionName() == "assert") {
         emitAssert(emitExpr(*expr.getArgs().front().getValue()), &expr, expr.getCallee().getLocation());
         return nullptr;
@@ -422,6 +446,11 @@ Value* IRGenerator::emitCallExpr(const CallExpr& expr, AllocaInst* thisAllocaFor
             args.emplace_back(getThis());
         }
         ++param;
+    } else if (auto* variableDecl = llvm::dyn_cast<VariableDecl>(calleeDecl); variableDecl && variableDecl->type.getClosureFunction()) {
+        auto* closure = getValue(variableDecl);
+        if (closure->getType()->isPointerType()) closure = createLoad(closure);
+        args.emplace_back(closure);
+        ++param;
     }
 
     for (const auto& arg : expr.getArgs()) {
@@ -431,6 +460,10 @@ Value* IRGenerator::emitCallExpr(const CallExpr& expr, AllocaInst* thisAllocaFor
         args.push_back(argValue);
     }
 
+    if (options.allocationProfile) {
+        emitAllocationSite(expr);
+    }
+
     if (calleeDecl->isConstructorDecl()) {
         createCall(calleeValue, args, &expr);
         return args[0];
@@ -445,6 +478,26 @@ Value* IRGenerator::emitBuiltinCast(const CallExpr& expr) {
     return createCastIfNeeded(value, type);
 }
 
+Value* IRGenerator::emitBuiltinAtomic(const CallExpr& expr) {
+    auto op = llvm::StringSwitch<AtomicOperation>(expr.getFunctionName())
+                  .Case("atomicLoad", AtomicOperation::Load)
+                  .Case("atomicStore", AtomicOperation::Store)
+                  .Case("atomicExchange", AtomicOperation::Exchange)
+                  .Case("atomicFetchAdd", AtomicOperation::Add)
+                  .Case("atomicFetchSub", AtomicOperation::Subtract)
+                  .Case("atomicFetchAnd", AtomicOperation::And)
+                  .Case("atomicFetchOr", AtomicOperation::Or)
+                  .Case("atomicFetchXor", AtomicOperation::Xor)
+                  .Case("atomicCompareExchange", AtomicOperation::CompareExchange);
+
+    auto args = expr.getArgs();
+    auto* pointer = emitExpr(*args[0].getValue());
+    auto* value = args.size() > 1 ? emitExpr(*args[1].getValue()) : nullptr;
+    auto* desired = args.size() > 2 ? emitExpr(*args[2].getValue()) : nullptr;
+    auto* atomic = createAtomic(op, pointer, value, desired);
+    return op == AtomicOperation::Store ? nullptr : atomic;
+}
+
 Value* IRGenerator::emitSizeofExpr(const SizeofExpr& expr) {
     return createSizeof(expr.getOperandType());
 }
@@ -491,7 +544,28 @@ Value* IRGenerator::emitMemberExpr(const MemberExpr& expr) {
         return emitTupleElementAccess(expr);
     }
 
-    return emitMemberAccess(emitLvalueExpr(*expr.getBaseExpr()), llvm::cast<FieldDecl>(expr.getDecl()), &expr);
+    auto* field = llvm::cast<FieldDecl>(expr.getDecl());
+    auto* baseTypeDecl = expr.getBaseExpr()->getType().removePointer().getDecl();
+    if (baseTypeDecl && baseTypeDecl->isStructOfArraysElement() && field->getParentDecl() != baseTypeDecl) {
+        return emitColumnAccess(expr, *baseTypeDecl);
+    }
+
+    return emitMemberAccess(emitLvalueExpr(*expr.getBaseExpr()), field, &expr);
+}
+
+// Returns a pointer to the entry of a SoAList element in the list's column for the accessed field:
+// &element.list.<field>[element.index]
+Value* IRGenerator::emitColumnAccess(const MemberExpr& expr, const TypeDecl& elementReferenceTypeDecl) {
+    auto* elementReference = emitExpr(*expr.getBaseExpr());
+    if (elementReference->getType()->isPointerType()) {
+        elementReference = createLoad(elementReference);
+    }
+
+    auto* list = createExtractValue(elementReference, 0, "list");
+    auto* index = createExtractValue(elementReference, 1, "index");
+    auto* listTypeDecl = elementReferenceTypeDecl.fields[0].type.getPointee().getDecl();
+    auto* column = createLoad(emitMemberAccess(list, listTypeDecl->getField(expr.getMemberName()), nullptr));
+    return createGEP(column, {index}, expr.getMemberName());
 }
 
 Value* IRGenerator::emitTupleElementAccess(const MemberExpr& expr) {
@@ -554,13 +628,42 @@ Value* IRGenerator::emitLambdaExpr(const LambdaExpr& expr) {
     auto functionDecl = expr.getFunctionDecl();
 
     auto insertBlockBackup = insertBlock;
+    auto currentFunctionBackup = currentFunction;
+    auto currentLocationBackup = currentLocation;
     auto scopesBackup = std::move(scopes);
+    auto valuesByDeclBackup = std::move(valuesByDecl);
+    valuesByDecl.clear();
 
     emitDecl(*functionDecl);
 
     scopes = std::move(scopesBackup);
+    valuesByDecl = std::move(valuesByDeclBackup);
+    currentFunction = currentFunctionBackup;
+    currentLocation = currentLocationBackup;
     if (insertBlockBackup) setInsertPoint(insertBlockBackup);
 
+    if (auto* closureType = functionDecl->closureType) {
+        // The closure is a struct of pointers to the captured variables, so it lives on the stack like any other
+        // struct value, and calls through it are direct calls to the lambda.
+        Value* closure = createUndefined(closureType->getType());
+
+        for (size_t i = 0; i < functionDecl->captures.size(); ++i) {
+            auto* capture = functionDecl->captures[i];
+            auto* value = getValue(capture);
+
+            // Parameters aren't stored in memory, so a copy of them is captured instead.
+            if (value->getType()->equals(getIRType(capture->type))) {
+                auto* copy = createEntryBlockAlloca(capture->type, capture->getName());
+                createStore(value, copy);
+                value = copy;
+            }
+
+            closure = createInsertValue(closure, value, int(i));
+        }
+
+        return closure;
+    }
+
     VarExpr varExpr(functionDecl->getName().str(), functionDecl->getLocation());
     varExpr.setDecl(functionDecl);
     varExpr.setType(expr.getType());
@@ -611,6 +714,7 @@ Value* IRGenerator::emitImplicitCastExpr(const ImplicitCastExpr& expr) {
 }
 
 Value* IRGenerator::emitPlainExpr(const Expr& expr) {
+    llvm::SaveAndRestore setLocation(currentLocation, getInstructionLocation(expr.getLocation()));
     if (expr.isConstant() && expr.getType().isInteger()) {
         return createConstantInt(expr.getType(), expr.getConstantIntegerValue());
     }
@@ -665,6 +769,7 @@ Value* IRGenerator::emitPlainExpr(const Expr& expr) {
 }
 
 Value* IRGenerator::emitExpr(const Expr& expr) {
+    llvm::SaveAndRestore setLocation(currentLocation, getInstructionLocation(expr.getLocation()));
     auto* value = emitLvalueExpr(expr);
 
     if (value && value->getType()->isPointerType() && value->getType()->getPointee()->equals(getIRType(expr.getType()))) {
@@ -701,6 +806,7 @@ Value* IRGenerator::emitExprOrEnumTag(const Expr& expr, Value** enumValue) {
 }
 
 Value* IRGenerator::emitLvalueExpr(const Expr& expr) {
+    llvm::SaveAndRestore setLocation(currentLocation, getInstructionLocation(expr.getLocation()));
     auto value = emitPlainExpr(expr);
 
     // Handle optionals that have been implicitly unwrapped due to data-flow analysis.
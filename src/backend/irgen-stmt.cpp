@@ -1,5 +1,7 @@
 #include "irgen.h"
 
+#include <llvm/Support/SaveAndRestore.h>
+
 using namespace cx;
 
 void IRGenerator::emitReturnStmt(const ReturnStmt& stmt) {
@@ -9,8 +11,12 @@ void IRGenerator::emitReturnStmt(const ReturnStmt& stmt) {
     emitDeferredExprsAndDestructorCallsForReturn();
 
     if (auto* returnValue = stmt.value) {
-        createReturn(emitExprForPassing(*returnValue, insertBlock->parent->returnType));
+        auto* value = emitExprForPassing(*returnValue, insertBlock->parent->returnType);
+        // Exit after evaluating the return value, so that calls in it are attributed to this function.
+        if (instrumentCurrentFunction) emitFunctionProfileHook("exitProfiledFunction", {});
+        createReturn(value);
     } else {
+        if (instrumentCurrentFunction) emitFunctionProfileHook("exitProfiledFunction", {});
         createReturn(currentDecl->isMain() ? createConstantInt(Type::getInt(), 0) : nullptr);
     }
 }
@@ -147,7 +153,28 @@ void IRGenerator::emitCompoundStmt(const CompoundStmt& compoundStmt) {
     endScope();
 }
 
+/// Returns the location of the statement, or an invalid location for statements whose instructions get their location
+/// from the expressions they contain.
+static Location getStmtLocation(const Stmt& stmt) {
+    switch (stmt.kind) {
+    case StmtKind::ReturnStmt:
+        return llvm::cast<ReturnStmt>(stmt).location;
+    case StmtKind::VarStmt:
+        return llvm::cast<VarStmt>(stmt).decl->getLocation();
+    case StmtKind::ForStmt:
+        return llvm::cast<ForStmt>(stmt).location;
+    case StmtKind::BreakStmt:
+        return llvm::cast<BreakStmt>(stmt).location;
+    case StmtKind::ContinueStmt:
+        return llvm::cast<ContinueStmt>(stmt).location;
+    default:
+        return Location();
+    }
+}
+
 void IRGenerator::emitStmt(const Stmt& stmt) {
+    llvm::SaveAndRestore setLocation(currentLocation, getInstructionLocation(getStmtLocation(stmt)));
+
     switch (stmt.kind) {
     case StmtKind::ReturnStmt:
         emitReturnStmt(llvm::cast<ReturnStmt>(stmt));
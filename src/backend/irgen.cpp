@@ -19,28 +19,38 @@ void IRGenScope::clear() {
     destructorsToCall.clear();
 }
 
-IRGenerator::IRGenerator() {
+IRGenerator::IRGenerator(IRGenOptions options) : options(std::move(options)) {
     scopes.push_back(IRGenScope(*this));
 }
 
 void IRGenerator::setLocalValue(Value* value, const VariableDecl* decl) {
-    auto it = scopes.back().valuesByDecl.try_emplace(decl, value);
-    ASSERT(it.second);
+    bool added = addValue(decl, value, scopes.size() - 1);
+    ASSERT(added);
 
     if (decl) {
         deferDestructorCall(value, decl);
     }
 }
 
-Value* IRGenerator::getValueOrNull(const Decl* decl) {
-    for (auto& scope : llvm::reverse(scopes)) {
-        auto it = scope.valuesByDecl.find(decl);
-        if (it != scope.valuesByDecl.end()) {
-            return it->second;
-        }
+bool IRGenerator::addValue(const Decl* decl, Value* value, size_t scopeIndex) {
+    auto [it, inserted] = valuesByDecl.try_emplace(decl, IRGenScope::ScopedValue{value, scopeIndex});
+
+    if (inserted) {
+        scopes[scopeIndex].previousValues.push_back({decl, std::nullopt});
+    } else {
+        if (it->second.scopeIndex == scopeIndex) return false;
+        ASSERT(it->second.scopeIndex < scopeIndex);
+        scopes[scopeIndex].previousValues.push_back({decl, it->second});
+        it->second = {value, scopeIndex};
     }
 
-    return nullptr;
+    return true;
+}
+
+Value* IRGenerator::getValueOrNull(const Decl* decl) {
+    auto it = valuesByDecl.find(decl);
+    if (it == valuesByDecl.end()) return nullptr;
+    return it->second.value;
 }
 
 Value* IRGenerator::getValue(const Decl* decl) {
@@ -77,6 +87,15 @@ void IRGenerator::beginScope() {
 
 void IRGenerator::endScope() {
     scopes.back().onScopeEnd();
+
+    for (auto& [decl, previousValue] : llvm::reverse(scopes.back().previousValues)) {
+        if (previousValue) {
+            valuesByDecl[decl] = *previousValue;
+        } else {
+            valuesByDecl.erase(decl);
+        }
+    }
+
     scopes.pop_back();
 }
 
@@ -126,17 +145,8 @@ void IRGenerator::emitDeferredExprsAndDestructorCallsForReturn() {
 
 AllocaInst* IRGenerator::createEntryBlockAlloca(IRType* type, const llvm::Twine& name) {
     auto alloca = new AllocaInst{ValueKind::AllocaInst, type, name.str()};
-    auto& entryBlock = currentFunction->body.front()->body;
-    auto insertPosition = entryBlock.end();
-
-    for (auto it = entryBlock.begin(), end = entryBlock.end(); it != end; ++it) {
-        if (!llvm::isa<AllocaInst>(*it)) {
-            insertPosition = it;
-            break;
-        }
-    }
-
-    entryBlock.insert(insertPosition, alloca);
+    alloca->location = currentFunction->location;
+    currentFunction->pendingAllocas.push_back(alloca);
     return alloca;
 }
 
@@ -147,18 +157,18 @@ AllocaInst* IRGenerator::createTempAlloca(Value* value) {
 }
 
 Value* IRGenerator::createLoad(Value* value, const Expr* expr) {
-    return insertBlock->add(new LoadInst{ValueKind::LoadInst, value, expr, value->getName() + ".load"});
+    return insert(new LoadInst{ValueKind::LoadInst, value, expr, value->getName() + ".load"});
 }
 
 void IRGenerator::createStore(Value* value, Value* pointer) {
     ASSERT(pointer->getType()->isPointerType());
     ASSERT(pointer->getType()->getPointee()->equals(value->getType()));
-    insertBlock->add(new StoreInst{ValueKind::StoreInst, value, pointer});
+    insert(new StoreInst{ValueKind::StoreInst, value, pointer});
 }
 
 Value* IRGenerator::createCall(Value* function, llvm::ArrayRef<Value*> args, const CallExpr* expr) {
     ASSERT(function->kind == ValueKind::Function || (function->getType()->isPointerType() && function->getType()->getPointee()->isFunctionType()));
-    return insertBlock->add(new CallInst{ValueKind::CallInst, function, args, expr, ""});
+    return insert(new CallInst{ValueKind::CallInst, function, args, expr, ""});
 }
 
 Value* IRGenerator::emitAssignmentLHS(const Expr& lhs) {
@@ -213,6 +223,9 @@ Value* IRGenerator::getFunctionForCall(const CallExpr& call) {
         return getFunction(*llvm::cast<FunctionDecl>(decl));
     case DeclKind::VarDecl:
     case DeclKind::ParamDecl:
+        if (auto* closureFunction = llvm::cast<VariableDecl>(decl)->type.getClosureFunction()) {
+            return getFunction(*closureFunction);
+        }
         return getValue(decl);
     case DeclKind::FieldDecl:
         if (call.getReceiver()) {
@@ -229,6 +242,7 @@ IRModule& IRGenerator::emitModule(const Module& sourceModule) {
     ASSERT(!module);
     module = new IRModule;
     module->name = sourceModule.getName().str();
+    moduleFunctions.clear();
 
     for (auto& sourceFile : sourceModule.getSourceFiles()) {
         for (auto& decl : sourceFile.getTopLevelDecls()) {
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 #pragma warning(push, 0)
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/Twine.h>
+#include <llvm/Support/GlobPattern.h>
 #pragma warning(pop)
 #include "../ast/decl.h"
 #include "../ast/expr.h"
@@ -27,19 +30,38 @@ struct IRGenScope {
         const Decl* decl;
     };
 
+    struct ScopedValue {
+        Value* value;
+        size_t scopeIndex;
+    };
+
     llvm::SmallVector<const Expr*, 8> deferredExprs;
     llvm::SmallVector<DeferredDestructor, 8> destructorsToCall;
-    llvm::DenseMap<const Decl*, Value*> valuesByDecl;
+    /// The decls given a value in this scope, with the values they had before, which are restored when the scope ends.
+    llvm::SmallVector<std::pair<const Decl*, std::optional<ScopedValue>>, 8> previousValues;
     IRGenerator* irGenerator;
 };
 
+struct IRGenOptions {
+    /// Pass the location of each call into std to the allocation profiler, see std/AllocationProfile.cx.
+    bool allocationProfile = false;
+    /// Call the function profiler on entry to and exit from functions, see std/FunctionProfile.cx.
+    bool instrumentFunctions = false;
+    /// Patterns matching the qualified names of the functions to instrument. If empty, functions outside std are instrumented.
+    std::vector<llvm::GlobPattern> instrumentedFunctionPatterns;
+};
+
 struct IRGenerator {
-    IRGenerator();
+    IRGenerator(IRGenOptions options = {});
     IRModule& emitModule(const Module& sourceModule);
     void emitFunctionBody(const FunctionDecl& decl, Function& function);
+    void emitClosureCaptures(const FunctionDecl& decl, Value* closure);
     void createDestructorCall(Function* destructor, Value* receiver);
     /// 'decl' is null if this is the 'this' value.
     void setLocalValue(Value* value, const VariableDecl* decl);
+    /// Gives the decl a value in the given scope, shadowing its value in outer scopes. Returns false if the decl already
+    /// has a value in that scope.
+    bool addValue(const Decl* decl, Value* value, size_t scopeIndex);
     Value* getValueOrNull(const Decl* decl);
     Value* getValue(const Decl* decl);
     Value* getThis(IRType* targetType = nullptr);
@@ -73,12 +95,17 @@ struct IRGenerator {
     Value* emitOptionalConstruction(Type wrappedType, Expr* arg);
     Value* emitOptionalUnwrap(Expr& operand, const Expr& expr, const llvm::Twine& name);
     void emitAssert(Value* condition, const Expr* expr, Location location, llvm::StringRef message = "Assertion failed", const llvm::Twine& name = "assert");
+    void emitAllocationSite(const CallExpr& expr);
+    bool shouldInstrumentFunction(const FunctionDecl& decl) const;
+    void emitFunctionProfileHook(llvm::StringRef hookName, llvm::ArrayRef<Value*> args);
     Value* emitEnumCase(const EnumCase& enumCase, llvm::ArrayRef<NamedValue> associatedValueElements);
     Value* emitCallExpr(const CallExpr& expr, AllocaInst* thisAllocaForInit = nullptr);
     Value* emitBuiltinCast(const CallExpr& expr);
+    Value* emitBuiltinAtomic(const CallExpr& expr);
     Value* emitSizeofExpr(const SizeofExpr& expr);
     Value* emitMemberAccess(Value* baseValue, const FieldDecl* field, const MemberExpr* expr = nullptr);
     Value* emitMemberExpr(const MemberExpr& expr);
+    Value* emitColumnAccess(const MemberExpr& expr, const TypeDecl& elementReferenceTypeDecl);
     Value* emitTupleElementAccess(const MemberExpr& expr);
     Value* emitIndexedAccess(const Expr& base, const Expr& index);
     Value* emitIndexExpr(const IndexExpr& expr);
@@ -111,19 +138,19 @@ struct IRGenerator {
     void createStore(Value* value, Value* pointer);
     Value* createCall(Value* function, llvm::ArrayRef<Value*> args, const CallExpr* expr);
     void createBr(BasicBlock* destination, Value* argument = nullptr) {
-        insertBlock->add(new BranchInst{ValueKind::BranchInst, destination, argument});
+        insert(new BranchInst{ValueKind::BranchInst, destination, argument});
         destination->predecessors.push_back(insertBlock);
     }
     void createCondBr(Value* condition, BasicBlock* trueBlock, BasicBlock* falseBlock, Value* argument = nullptr) {
-        insertBlock->add(new CondBranchInst{ValueKind::CondBranchInst, condition, trueBlock, falseBlock, argument});
+        insert(new CondBranchInst{ValueKind::CondBranchInst, condition, trueBlock, falseBlock, argument});
         trueBlock->predecessors.push_back(insertBlock);
         falseBlock->predecessors.push_back(insertBlock);
     }
     Value* createInsertValue(Value* aggregate, Value* value, int index) {
-        return insertBlock->add(new InsertInst{ValueKind::InsertInst, aggregate, value, index, ""});
+        return insert(new InsertInst{ValueKind::InsertInst, aggregate, value, index, ""});
     }
     Value* createExtractValue(Value* aggregate, int index, const llvm::Twine& name = "") {
-        return insertBlock->add(new ExtractInst{ValueKind::ExtractInst, aggregate, index, name.str()});
+        return insert(new ExtractInst{ValueKind::ExtractInst, aggregate, index, name.str()});
     }
     Value* createConstantInt(IRType* type, llvm::APSInt value) { return new ConstantInt{ValueKind::ConstantInt, type, std::move(value)}; }
     Value* createConstantInt(IRType* type, int64_t value) { return createConstantInt(type, llvm::APSInt::get(value)); }
@@ -143,7 +170,7 @@ struct IRGenerator {
     Value* createUndefined(Type type) { return createUndefined(getIRType(type)); }
     Value* createBinaryOp(BinaryOperator op, Value* left, Value* right, const Expr* expr, const llvm::Twine& name = "") {
         ASSERT(left->getType()->equals(right->getType()));
-        return insertBlock->add(new BinaryInst{ValueKind::BinaryInst, op, left, right, expr, name.str()});
+        return insert(new BinaryInst{ValueKind::BinaryInst, op, left, right, expr, name.str()});
     }
     Value* createIsNull(Value* value, const Expr* expr, const llvm::Twine& name) {
         Value* nullValue;
@@ -163,10 +190,10 @@ struct IRGenerator {
 
         return createBinaryOp(Token::Equal, value, nullValue, expr, name);
     }
-    Value* createNeg(Value* value) { return insertBlock->add(new UnaryInst{ValueKind::UnaryInst, Token::Minus, value, nullptr, ""}); }
-    Value* createNot(Value* value) { return insertBlock->add(new UnaryInst{ValueKind::UnaryInst, Token::Not, value, nullptr, ""}); }
+    Value* createNeg(Value* value) { return insert(new UnaryInst{ValueKind::UnaryInst, Token::Minus, value, nullptr, ""}); }
+    Value* createNot(Value* value) { return insert(new UnaryInst{ValueKind::UnaryInst, Token::Not, value, nullptr, ""}); }
     Value* createGEP(Value* pointer, std::vector<Value*> indexes, const llvm::Twine& name = "") {
-        return insertBlock->add(new GEPInst{ValueKind::GEPInst, pointer, std::move(indexes), name.str()});
+        return insert(new GEPInst{ValueKind::GEPInst, pointer, std::move(indexes), name.str()});
     }
     Value* createGEP(Value* pointer, int index, const MemberExpr* expr = nullptr, const llvm::Twine& name = "") {
         if (pointer->getType()->getPointee()->isArrayType()) {
@@ -174,11 +201,11 @@ struct IRGenerator {
         } else {
             ASSERT(index < pointer->getType()->getPointee()->getFields().size());
         }
-        return insertBlock->add(new ConstGEPInst{ValueKind::ConstGEPInst, pointer, index, expr, name.str()});
+        return insert(new ConstGEPInst{ValueKind::ConstGEPInst, pointer, index, expr, name.str()});
     }
     Value* createCast(Value* value, IRType* type, const llvm::Twine& name = "") {
         ASSERT(!value->getType()->equals(type));
-        return insertBlock->add(new CastInst{ValueKind::CastInst, value, type, name.str()});
+        return insert(new CastInst{ValueKind::CastInst, value, type, name.str()});
     }
     Value* createCast(Value* value, Type type, const llvm::Twine& name = "") { return createCast(value, getIRType(type), name); }
     Value* createCastIfNeeded(Value* value, IRType* type, const llvm::Twine& name = "") {
@@ -186,16 +213,21 @@ struct IRGenerator {
         return createCast(value, type, name);
     }
     Value* createCastIfNeeded(Value* value, Type type, const llvm::Twine& name = "") { return createCastIfNeeded(value, getIRType(type), name); }
-    Value* createGlobalVariable(Value* value, Type type, const llvm::Twine& name = "") {
-        return module->globalVariables.emplace_back(new GlobalVariable{ValueKind::GlobalVariable, getIRType(type), value, name.str()});
+    Value* createGlobalVariable(Value* value, Type type, const llvm::Twine& name = "", bool isThreadLocal = false) {
+        return module->globalVariables.emplace_back(new GlobalVariable{ValueKind::GlobalVariable, getIRType(type), value, name.str(), isThreadLocal});
     }
     Value* createGlobalStringPtr(llvm::StringRef value) { return new ConstantString{ValueKind::ConstantString, value.str()}; }
     Value* createSizeof(Type type) { return new SizeofInst{ValueKind::SizeofInst, getIRType(type), ""}; }
     SwitchInst* createSwitch(Value* condition, BasicBlock* defaultBlock) {
-        return insertBlock->add(new SwitchInst{ValueKind::SwitchInst, condition, defaultBlock, {}});
+        return insert(new SwitchInst{ValueKind::SwitchInst, condition, defaultBlock, {}});
+    }
+    Value* createAtomic(AtomicOperation op, Value* pointer, Value* value, Value* desired = nullptr) {
+        ASSERT(pointer->getType()->isPointerType());
+        ASSERT(!value || pointer->getType()->getPointee()->equals(value->getType()));
+        return insert(new AtomicInst{ValueKind::AtomicInst, op, pointer, value, desired, ""});
     }
-    void createUnreachable() { insertBlock->add(new UnreachableInst{ValueKind::UnreachableInst}); }
-    void createReturn(Value* value) { insertBlock->add(new ReturnInst{ValueKind::ReturnInst, value}); }
+    void createUnreachable() { insert(new UnreachableInst{ValueKind::UnreachableInst}); }
+    void createReturn(Value* value) { insert(new ReturnInst{ValueKind::ReturnInst, value}); }
     Value* getArrayLength(const Expr& object, Type objectType);
     Value* getArrayIterator(const Expr& object, Type objectType);
     void beginScope();
@@ -203,8 +235,13 @@ struct IRGenerator {
     void deferEvaluationOf(const Expr& expr);
     DestructorDecl* getDefaultDestructor(TypeDecl& typeDecl);
     void deferDestructorCall(Value* receiver, const VariableDecl* decl);
-    IRGenScope& globalScope() { return scopes.front(); }
     void setInsertPoint(BasicBlock* block);
+    /// Adds the instruction to the end of the insert block, tagged with the current source location.
+    template<typename T> T* insert(T* inst) {
+        inst->location = currentLocation;
+        return insertBlock->add(inst);
+    }
+    Location getInstructionLocation(Location location) const { return location.isValid() ? location : currentLocation; }
 
     struct FunctionInstantiation {
         const FunctionDecl* decl;
@@ -212,15 +249,28 @@ struct IRGenerator {
     };
 
     std::vector<IRGenScope> scopes;
+    /// The value of each decl in the innermost scope that defines it. Scopes record the values they shadow, so lookups
+    /// don't need to search each scope.
+    llvm::DenseMap<const Decl*, IRGenScope::ScopedValue> valuesByDecl;
     IRModule* module = nullptr;
     std::vector<IRModule*> generatedModules;
     std::vector<FunctionInstantiation> functionInstantiations;
+    /// The function that owns the definition of each mangled name, i.e. the declaration in the first module that
+    /// referenced it. Other modules declare the function and call the owner's definition.
+    llvm::StringMap<Function*> functionOwners;
+    /// Functions declared in the module currently being generated, by mangled name.
+    llvm::StringMap<Function*> moduleFunctions;
     const Decl* currentDecl;
     /// The basic blocks to branch to on a 'break'/'continue' statement.
     llvm::SmallVector<BasicBlock*, 4> breakTargets;
     llvm::SmallVector<BasicBlock*, 4> continueTargets;
     BasicBlock* insertBlock;
     Function* currentFunction = nullptr;
+    /// The location of the innermost statement or expression being emitted, given to the instructions created for it.
+    Location currentLocation;
+    IRGenOptions options;
+    /// Whether the function being generated calls the function profiler on entry and exit.
+    bool instrumentCurrentFunction = false;
     static const int optionalHasValueFieldIndex = 0;
     static const int optionalValueFieldIndex = 1;
 };
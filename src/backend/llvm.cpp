@@ -3,8 +3,10 @@
 #include <llvm/ADT/SmallString.h>
 #include <llvm/ADT/StringSwitch.h>
 #include <llvm/IR/CFG.h>
+#include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Support/Path.h>
 #pragma warning(pop)
 
 #include "ir.h"
@@ -140,20 +142,56 @@ llvm::Function* LLVMGenerator::getFunction(const Function* function) {
     return llvmFunction;
 }
 
+llvm::DIFile* LLVMGenerator::getDebugFile(llvm::StringRef filePath) {
+    auto*& file = debugFiles[filePath];
+    if (!file) {
+        file = debugInfoBuilder->createFile(llvm::sys::path::filename(filePath), llvm::sys::path::parent_path(filePath));
+    }
+    return file;
+}
+
+llvm::DISubprogram* LLVMGenerator::createDebugSubprogram(const Function* function) {
+    if (!debugInfoBuilder || !function->location.isValid() || !function->location.file) return nullptr;
+
+    auto* file = getDebugFile(function->location.file);
+    auto* subroutineType = debugInfoBuilder->createSubroutineType(debugInfoBuilder->getOrCreateTypeArray({}));
+    unsigned line = function->location.line;
+    return debugInfoBuilder->createFunction(file, function->mangledName, "", file, line, subroutineType, line, llvm::DINode::FlagPrototyped,
+                                            llvm::DISubprogram::SPFlagDefinition);
+}
+
+/// Sets the location of the instructions generated for the given IR instruction. Instructions without a location, or
+/// with a location in another file than their function, e.g. from a default argument, get the location of the function.
+void LLVMGenerator::setDebugLocation(const Value* inst, const Function* function) {
+    auto location = inst->location;
+    if (!location.isValid() || llvm::StringRef(location.file) != function->location.file) {
+        location = function->location;
+    }
+    builder.SetCurrentDebugLocation(llvm::DILocation::get(ctx, location.line, location.column, currentSubprogram));
+}
+
 void LLVMGenerator::codegenFunctionBody(const Function* function, llvm::Function* llvmFunction) {
     isCurrentFunctionSret = shouldUseSret(getLLVMType(function->returnType));
     llvm::IRBuilder<>::InsertPointGuard insertPointGuard(builder);
 
+    currentSubprogram = createDebugSubprogram(function);
+    if (currentSubprogram) {
+        llvmFunction->setSubprogram(currentSubprogram);
+    }
+
+    functionValues.assign(function->valueCount, nullptr);
+
     auto arg = llvmFunction->arg_begin();
     if (isCurrentFunctionSret) ++arg;
     for (auto& param : function->params) {
-        generatedValues.emplace(&param, &*arg++);
+        setValue(&param, &*arg++);
     }
 
     for (auto* block : function->body) {
         auto llvmBlock = getBasicBlock(block);
         llvmBlock->insertInto(llvmFunction);
         builder.SetInsertPoint(llvmBlock);
+        if (currentSubprogram && !block->body.empty()) setDebugLocation(block->body.front(), function);
 
         if (block->parameter) {
             auto phi = builder.CreatePHI(getLLVMType(block->parameter->type), 2, block->parameter->name);
@@ -162,12 +200,13 @@ void LLVMGenerator::codegenFunctionBody(const Function* function, llvm::Function
                 auto target = getBasicBlock(pred);
                 phi->addIncoming(value, target);
             }
-            generatedValues.emplace(block->parameter, phi);
+            setValue(block->parameter, phi);
         }
 
         for (auto* inst : block->body) {
+            if (currentSubprogram) setDebugLocation(inst, function);
             auto llvmValue = codegenInst(inst);
-            generatedValues.emplace(inst, llvmValue);
+            setValue(inst, llvmValue);
         }
     }
 
@@ -175,6 +214,11 @@ void LLVMGenerator::codegenFunctionBody(const Function* function, llvm::Function
     if (insertBlock && insertBlock != &llvmFunction->getEntryBlock() && llvm::pred_empty(insertBlock)) {
         insertBlock->eraseFromParent();
     }
+
+    if (currentSubprogram) {
+        debugInfoBuilder->finalizeSubprogram(currentSubprogram);
+        currentSubprogram = nullptr;
+    }
 }
 
 void LLVMGenerator::codegenFunction(const Function* function) {
@@ -402,6 +446,49 @@ llvm::Value* LLVMGenerator::codegenCast(const CastInst* inst) {
     return builder.CreateBitOrPointerCast(value, getLLVMType(type), inst->name);
 }
 
+llvm::Value* LLVMGenerator::codegenAtomic(const AtomicInst* inst) {
+    auto pointer = getValue(inst->pointer);
+    auto ordering = llvm::AtomicOrdering::SequentiallyConsistent;
+    llvm::AtomicRMWInst::BinOp binOp;
+
+    switch (inst->op) {
+    case AtomicOperation::Load: {
+        auto load = builder.CreateLoad(getLLVMType(inst->getType()), pointer, inst->name);
+        load->setAtomic(ordering);
+        return load;
+    }
+    case AtomicOperation::Store: {
+        auto store = builder.CreateStore(getValue(inst->value), pointer);
+        store->setAtomic(ordering);
+        return store;
+    }
+    case AtomicOperation::CompareExchange: {
+        auto cmpxchg = builder.CreateAtomicCmpXchg(pointer, getValue(inst->value), getValue(inst->desired), llvm::MaybeAlign(), ordering, ordering);
+        return builder.CreateExtractValue(cmpxchg, 1, inst->name);
+    }
+    case AtomicOperation::Exchange:
+        binOp = llvm::AtomicRMWInst::Xchg;
+        break;
+    case AtomicOperation::Add:
+        binOp = llvm::AtomicRMWInst::Add;
+        break;
+    case AtomicOperation::Subtract:
+        binOp = llvm::AtomicRMWInst::Sub;
+        break;
+    case AtomicOperation::And:
+        binOp = llvm::AtomicRMWInst::And;
+        break;
+    case AtomicOperation::Or:
+        binOp = llvm::AtomicRMWInst::Or;
+        break;
+    case AtomicOperation::Xor:
+        binOp = llvm::AtomicRMWInst::Xor;
+        break;
+    }
+
+    return builder.CreateAtomicRMW(binOp, pointer, getValue(inst->value), llvm::MaybeAlign(), ordering);
+}
+
 llvm::Value* LLVMGenerator::codegenUnreachable() {
     return builder.CreateUnreachable();
 }
@@ -417,7 +504,8 @@ llvm::Value* LLVMGenerator::codegenBasicBlock(const BasicBlock* block) {
 llvm::Value* LLVMGenerator::codegenGlobalVariable(const GlobalVariable* inst) {
     auto linkage = inst->value ? llvm::GlobalValue::PrivateLinkage : llvm::GlobalValue::ExternalLinkage;
     auto initializer = inst->value ? llvm::cast<llvm::Constant>(getValue(inst->value)) : nullptr;
-    return new llvm::GlobalVariable(*module, getLLVMType(inst->type), false, linkage, initializer, inst->name);
+    auto threadLocalMode = inst->isThreadLocal ? llvm::GlobalValue::GeneralDynamicTLSModel : llvm::GlobalValue::NotThreadLocal;
+    return new llvm::GlobalVariable(*module, getLLVMType(inst->type), false, linkage, initializer, inst->name, nullptr, threadLocalMode);
 }
 
 llvm::Value* LLVMGenerator::codegenConstantString(const ConstantString* inst) {
@@ -448,6 +536,13 @@ llvm::Value* LLVMGenerator::codegenUndefined(const Undefined* inst) {
 }
 
 llvm::Value* LLVMGenerator::getValue(const Value* value) {
+    if (value->index < functionValues.size()) {
+        if (auto* llvmValue = functionValues[value->index]) return llvmValue;
+        auto* llvmValue = codegenInst(value);
+        setValue(value, llvmValue);
+        return llvmValue;
+    }
+
     auto it = generatedValues.find(value);
     if (it != generatedValues.end()) return it->second;
     auto llvmValue = codegenInst(value);
@@ -455,6 +550,15 @@ llvm::Value* LLVMGenerator::getValue(const Value* value) {
     return llvmValue;
 }
 
+void LLVMGenerator::setValue(const Value* value, llvm::Value* llvmValue) {
+    if (value->index < functionValues.size()) {
+        auto& generatedValue = functionValues[value->index];
+        if (!generatedValue) generatedValue = llvmValue;
+    } else {
+        generatedValues.emplace(value, llvmValue);
+    }
+}
+
 llvm::Value* LLVMGenerator::codegenInst(const Value* value) {
     switch (value->kind) {
     case ValueKind::AllocaInst:
@@ -487,6 +591,8 @@ llvm::Value* LLVMGenerator::codegenInst(const Value* value) {
         return codegenConstGEP(llvm::cast<ConstGEPInst>(value));
     case ValueKind::CastInst:
         return codegenCast(llvm::cast<CastInst>(value));
+    case ValueKind::AtomicInst:
+        return codegenAtomic(llvm::cast<AtomicInst>(value));
     case ValueKind::UnreachableInst:
         return codegenUnreachable();
     case ValueKind::SizeofInst:
@@ -496,6 +602,7 @@ llvm::Value* LLVMGenerator::codegenInst(const Value* value) {
     case ValueKind::Function:
         return getFunction(llvm::cast<Function>(value));
     case ValueKind::Parameter:
+        if (value->index < functionValues.size()) return NOTNULL(functionValues[value->index]);
         return generatedValues.at(value);
     case ValueKind::GlobalVariable:
         return codegenGlobalVariable(llvm::cast<GlobalVariable>(value));
@@ -520,6 +627,13 @@ llvm::Module& LLVMGenerator::codegenModule(const IRModule& sourceModule) {
     ASSERT(!module);
     module = new llvm::Module(sourceModule.name, ctx);
 
+    if (emitDebugInfo) {
+        debugInfoBuilder = std::make_unique<llvm::DIBuilder>(*module);
+        debugInfoBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, getDebugFile(sourceModule.name), "cx", false, "", 0);
+        module->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+        module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+    }
+
     for (auto* globalVariable : sourceModule.globalVariables) {
         getValue(globalVariable);
     }
@@ -528,6 +642,12 @@ llvm::Module& LLVMGenerator::codegenModule(const IRModule& sourceModule) {
         codegenFunction(function);
     }
 
+    if (debugInfoBuilder) {
+        debugInfoBuilder->finalize();
+        debugInfoBuilder.reset();
+        debugFiles.clear();
+    }
+
     ASSERT(!llvm::verifyModule(*module, &llvm::errs()));
     generatedModules.push_back(module);
     module = nullptr;
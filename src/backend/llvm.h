@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #pragma warning(push, 0)
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
 #pragma warning(pop)
 #include "ir.h"
@@ -17,7 +20,7 @@ struct Function;
 struct BasicBlock;
 
 struct LLVMGenerator {
-    LLVMGenerator() : builder(ctx) {}
+    LLVMGenerator(bool emitDebugInfo = false) : builder(ctx), emitDebugInfo(emitDebugInfo) {}
     llvm::Module& codegenModule(const IRModule& sourceModule);
     llvm::Value* codegenAlloca(const AllocaInst* inst);
     llvm::Value* codegenReturn(const ReturnInst* inst);
@@ -34,6 +37,7 @@ struct LLVMGenerator {
     llvm::Value* codegenGEP(const GEPInst* inst);
     llvm::Value* codegenConstGEP(const ConstGEPInst* inst);
     llvm::Value* codegenCast(const CastInst* inst);
+    llvm::Value* codegenAtomic(const AtomicInst* inst);
     llvm::Value* codegenUnreachable();
     llvm::Value* codegenSizeof(const SizeofInst* inst);
     llvm::Value* codegenBasicBlock(const BasicBlock* block);
@@ -45,6 +49,7 @@ struct LLVMGenerator {
     llvm::Value* codegenConstantNull(const ConstantNull* inst);
     llvm::Value* codegenUndefined(const Undefined* inst);
     llvm::Value* getValue(const Value* value);
+    void setValue(const Value* value, llvm::Value* llvmValue);
     llvm::Value* codegenInst(const Value* value);
     llvm::BasicBlock* getBasicBlock(const BasicBlock* block);
     llvm::Function* getFunction(const Function* function);
@@ -54,14 +59,26 @@ struct LLVMGenerator {
     bool shouldUseSret(llvm::Type* returnType);
     llvm::Type* getBuiltinType(llvm::StringRef name);
     llvm::Type* getStructType(IRStructType* type);
+    llvm::DIFile* getDebugFile(llvm::StringRef filePath);
+    llvm::DISubprogram* createDebugSubprogram(const Function* function);
+    void setDebugLocation(const Value* inst, const Function* function);
 
     llvm::LLVMContext ctx;
     llvm::IRBuilder<> builder;
     llvm::Module* module = nullptr;
     std::vector<llvm::Module*> generatedModules;
+    /// Generated values of the current function, indexed by Value::index.
+    std::vector<llvm::Value*> functionValues;
+    /// Generated values that have no index in the current function, e.g. globals and constants.
     std::unordered_map<const Value*, llvm::Value*> generatedValues;
     std::unordered_map<IRType*, llvm::StructType*> structs;
     bool isCurrentFunctionSret;
+    bool emitDebugInfo;
+    /// Debug info builder for the module being generated, when emitting debug info.
+    std::unique_ptr<llvm::DIBuilder> debugInfoBuilder;
+    llvm::StringMap<llvm::DIFile*> debugFiles;
+    /// Debug info of the function whose body is being generated, or null if it has none.
+    llvm::DISubprogram* currentSubprogram = nullptr;
 };
 
 } // namespace cx
@@ -13,6 +13,7 @@
 #include <llvm/IR/Module.h>
 #include <llvm/Linker/Linker.h>
 #include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
@@ -27,6 +28,7 @@
 #pragma warning(pop)
 #include "../ast/module.h"
 #include "../backend/c-backend.h"
+#include "../backend/function-folding.h"
 #include "../backend/irgen.h"
 #include "../backend/llvm.h"
 #include "../package-manager/manifest.h"
@@ -52,6 +54,7 @@ int errors = 0;
 
 cl::SubCommand build("build", "Build a C* project");
 cl::SubCommand run("run", "Build and run a C* executable");
+cl::SubCommand bench("bench", "Build and run the benchmarks of a C* project");
 
 cl::OptionCategory dependencyCategory("Dependency Options");
 cl::list<std::string> inputs(cl::Positional, cl::desc("<input files>"), cl::sub(cl::SubCommand::getAll()), cl::cat(dependencyCategory));
@@ -91,6 +94,22 @@ cl::alias emitAssemblyAlias("S", cl::aliasopt(emitAssembly), cl::cat(outputCateg
 cl::opt<bool> emitBitcode("emit-llvm-bitcode", cl::desc("Emit LLVM bitcode"), cl::cat(outputCategory));
 cl::opt<bool> noPIE("no-pie", cl::desc("Don't produce a position-independent executable"), cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
 cl::opt<std::string> specifiedOutputFileName("o", cl::desc("Specify output file name"), cl::cat(outputCategory));
+cl::opt<unsigned> optimizationLevel("O", cl::desc("Optimization level (0-3)"), cl::Prefix, cl::init(0), cl::sub(cl::SubCommand::getAll()),
+                                   cl::cat(outputCategory));
+cl::opt<std::string> benchmarkResultsPath("results", cl::desc("Write the benchmark results as JSON to the given file"), cl::value_desc("path"), cl::sub(bench),
+                                          cl::cat(outputCategory));
+cl::opt<bool> debugInfo("g", cl::desc("Generate debug information, e.g. for debuggers and profilers"), cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
+cl::opt<bool> allocationProfile("fallocation-profile",
+                                cl::desc("Record the call site, size and lifetime of heap allocations, and print a report of the top allocating call sites at exit"),
+                                cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
+cl::opt<bool> instrumentFunctions("finstrument-functions",
+                                  cl::desc("Record the time spent in each function, and write it as folded stacks for flame graphs at exit"),
+                                  cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
+cl::list<std::string> instrumentedFunctions("finstrument-functions-allow",
+                                            cl::desc("Instrument only the functions whose qualified names match one of the given glob patterns"),
+                                            cl::value_desc("patterns"), cl::CommaSeparated, cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
+cl::opt<bool> noFoldFunctions("fno-fold-functions", cl::desc("Don't merge functions with identical bodies, e.g. generic instantiations for different pointer types"),
+                              cl::sub(cl::SubCommand::getAll()), cl::cat(outputCategory));
 
 cl::OptionCategory diagnosticCategory("Diagnostic Options");
 cl::opt<bool> disableWarnings("w", cl::desc("Disable all warnings"), cl::sub(cl::SubCommand::getAll()), cl::cat(diagnosticCategory));
@@ -177,6 +196,24 @@ static void addPredefinedImportSearchPaths(llvm::ArrayRef<std::string> inputFile
     addHeaderSearchPathsFromCCompilerOutput();
 }
 
+static void optimizeLLVMModule(llvm::Module& module, llvm::TargetMachine* targetMachine, unsigned level) {
+    llvm::LoopAnalysisManager loopAnalysisManager;
+    llvm::FunctionAnalysisManager functionAnalysisManager;
+    llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+    llvm::ModuleAnalysisManager moduleAnalysisManager;
+
+    llvm::PassBuilder passBuilder(targetMachine);
+    passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+    passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+    passBuilder.registerLoopAnalyses(loopAnalysisManager);
+    passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+    auto optimizationLevel = level == 1 ? llvm::OptimizationLevel::O1 : level == 2 ? llvm::OptimizationLevel::O2 : llvm::OptimizationLevel::O3;
+    auto modulePassManager = passBuilder.buildPerModuleDefaultPipeline(optimizationLevel);
+    modulePassManager.run(module, moduleAnalysisManager);
+}
+
 static void emitLLVMModuleToMachineCode(llvm::Module& module, llvm::StringRef fileName, llvm::CodeGenFileType fileType, llvm::Reloc::Model relocModel) {
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
@@ -194,6 +231,10 @@ static void emitLLVMModuleToMachineCode(llvm::Module& module, llvm::StringRef fi
     auto* targetMachine = target->createTargetMachine(targetTriple, "generic", "", options, relocModel);
     module.setDataLayout(targetMachine->createDataLayout());
 
+    if (optimizationLevel > 0) {
+        optimizeLLVMModule(module, targetMachine, optimizationLevel);
+    }
+
     std::error_code error;
     llvm::raw_fd_ostream file(fileName, error, llvm::sys::fs::OF_None);
     if (error) ABORT(error.message());
@@ -231,6 +272,42 @@ static int buildModuleFromFiles(BuildParams buildParams) {
     return buildModule(mainModule, std::move(buildParams));
 }
 
+/// Adds a main function to the module that runs each benchmark function in it, i.e. each top-level function whose name
+/// starts with "benchmark" and that takes a single Benchmark pointer, and writes the results to the given JSON file.
+static void addBenchmarkRunner(Module& mainModule, const CompileOptions& options, llvm::StringRef resultsPath) {
+    std::string source = "void main() {\n    var benchmarks = List<Benchmark>();\n";
+    int benchmarkCount = 0;
+
+    for (auto& sourceFile : mainModule.getSourceFiles()) {
+        for (auto* decl : sourceFile.getTopLevelDecls()) {
+            auto* functionDecl = llvm::dyn_cast<FunctionDecl>(decl);
+            if (!functionDecl || !functionDecl->getName().starts_with("benchmark") || functionDecl->getParams().size() != 1) continue;
+            auto paramType = functionDecl->getParams()[0].type;
+            if (!paramType.isPointerType() || paramType.getPointee().getName() != "Benchmark") continue;
+
+            auto name = functionDecl->getName().str();
+            source += "    benchmarks.push(runBenchmark(\"" + name + "\", " + name + "));\n";
+            benchmarkCount++;
+        }
+    }
+
+    if (benchmarkCount == 0) {
+        llvm::errs() << "warning: no benchmark functions found, expected functions like 'void benchmarkName(Benchmark* benchmark)'\n";
+    }
+
+    std::string escapedResultsPath;
+    for (char c : resultsPath) {
+        if (c == '\\' || c == '"') escapedResultsPath += '\\';
+        escapedResultsPath += c;
+    }
+    const char* backendName = backend == Backend::C ? "c" : "llvm";
+    source += "    writeBenchmarkResults(benchmarks, \"" + escapedResultsPath + "\", \"" + backendName + "\", " + std::to_string(optimizationLevel) + ");\n}\n";
+
+    mainModule.fileBuffers.push_back(llvm::MemoryBuffer::getMemBufferCopy(source, "benchmark-runner.cx"));
+    Parser parser(*mainModule.fileBuffers.back(), mainModule, options);
+    parser.parse();
+}
+
 int cx::buildModule(Module& mainModule, BuildParams buildParams) {
     if (mainModule.fileBuffers.empty()) {
         ABORT("no input files");
@@ -257,6 +334,15 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
         parser.parse();
     }
 
+    if (bench) {
+        llvm::SmallString<128> resultsPath(benchmarkResultsPath.getValue());
+        if (resultsPath.empty()) {
+            resultsPath = buildParams.outputDirectory;
+            llvm::sys::path::append(resultsPath, buildParams.outputFileName.empty() ? "benchmarks.json" : buildParams.outputFileName + ".benchmarks.json");
+        }
+        addBenchmarkRunner(mainModule, options, resultsPath);
+    }
+
     if (parse) return errors ? 1 : 0;
 
     Typechecker typechecker(options);
@@ -274,7 +360,16 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
         if (!remainingPrintOpts) return 0;
     }
 
-    IRGenerator irGenerator;
+    IRGenOptions irGenOptions;
+    irGenOptions.allocationProfile = allocationProfile;
+    irGenOptions.instrumentFunctions = instrumentFunctions;
+    for (auto& pattern : instrumentedFunctions) {
+        auto globPattern = llvm::GlobPattern::create(pattern);
+        if (!globPattern) ABORT("invalid pattern '" << pattern << "' for -finstrument-functions-allow: " << llvm::toString(globPattern.takeError()));
+        irGenOptions.instrumentedFunctionPatterns.push_back(std::move(*globPattern));
+    }
+
+    IRGenerator irGenerator(std::move(irGenOptions));
     for (auto* importedModule : Module::getAllImportedModules()) {
         irGenerator.emitModule(*importedModule);
     }
@@ -303,6 +398,11 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
         if (!remainingPrintOpts) return 0;
     }
 
+    if (!noFoldFunctions) {
+        FunctionFolder functionFolder;
+        functionFolder.fold(irGenerator.generatedModules);
+    }
+
     llvm::SmallString<128> tempIntermediateFilePath;
     const char* outputFileExtension;
     // Prefer external C compiler for better system compatibility, fallback to embedded Clang.
@@ -313,7 +413,7 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
 
     switch (backend.getValue()) {
     case Backend::C: {
-        CGenerator cGen;
+        CGenerator cGen(debugInfo);
         for (auto* irModule : irGenerator.generatedModules) {
             cGen.codegenModule(*irModule);
         }
@@ -338,7 +438,7 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
         break;
     }
     case Backend::LLVM:
-        LLVMGenerator llvmGenerator;
+        LLVMGenerator llvmGenerator(debugInfo);
         for (auto* irModule : irGenerator.generatedModules) {
             llvmGenerator.codegenModule(*irModule);
         }
@@ -382,7 +482,7 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
         if (error) ABORT(error.message());
     }
 
-    bool treatAsLibrary = mainModule.getSymbolTable().findInTopLevelScope("main").empty() && !run;
+    bool treatAsLibrary = mainModule.getSymbolTable().findInTopLevelScope("main").empty() && !run && !bench;
     if (treatAsLibrary && !buildParams.createSharedLib) {
         compileOnly = true;
     }
@@ -415,6 +515,14 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
     }
     ccArgs.push_back(isMSVC ? "-Fe:" : "-o");
     ccArgs.push_back(tempOutputFilePath.c_str());
+    std::string optimizationFlag;
+    if (optimizationLevel > 0) {
+        optimizationFlag = isMSVC ? (optimizationLevel == 1 ? "-O1" : "-O2") : "-O" + std::to_string(optimizationLevel);
+        ccArgs.push_back(optimizationFlag.c_str());
+    }
+    if (debugInfo) {
+        ccArgs.push_back(isMSVC ? "-Zi" : "-g");
+    }
 
     if (backend == Backend::C) {
         // TODO: remove these and fix errors
@@ -459,7 +567,7 @@ int cx::buildModule(Module& mainModule, BuildParams buildParams) {
     llvm::sys::fs::remove(tempIntermediateFilePath);
     if (ccExitStatus != 0) return ccExitStatus;
 
-    if (run) {
+    if (run || bench) {
         std::string command = (tempOutputFilePath + " 2>&1").str();
         std::string output;
         int executableExitStatus = exec(command.c_str(), output);
@@ -547,6 +655,8 @@ static void addPlatformCompileOptions() {
 #ifdef _WIN32
     defines.push_back("Windows");
     cflags.push_back("-fms-extensions");
+#else
+    cflags.push_back("-pthread"); // Required by std/Thread.cx.
 #endif
 #ifdef __APPLE__
     defines.push_back("macOS");
@@ -566,6 +676,18 @@ int cx::driverMain(int argc, const char** argv) {
     cl::HideUnrelatedOptions({&stageSelectionCategory, &outputCategory, &dependencyCategory, &diagnosticCategory});
     cl::ParseCommandLineOptions(argc, argv, "C* compiler\n");
     addPlatformCompileOptions();
+    if (optimizationLevel > 3) {
+        ABORT("invalid optimization level -O" << optimizationLevel << ", expected 0-3");
+    }
+    if (bench) {
+        defines.push_back("Bench"); // Allows excluding the program's own main function from benchmark builds with '#if !Bench'.
+    }
+    if (allocationProfile) {
+        defines.push_back("AllocationProfile"); // Selects the instrumented allocation functions in std/AllocationProfile.cx.
+    }
+    if (instrumentFunctions) {
+        defines.push_back("InstrumentFunctions"); // Selects the function profiler hooks in std/FunctionProfile.cx.
+    }
 
     if (!inputs.empty()) {
         return buildModuleFromFiles({
@@ -575,7 +697,7 @@ int cx::driverMain(int argc, const char** argv) {
             .outputDirectory = ".",
             .outputFileName = "",
         });
-    } else if (build || run) {
+    } else if (build || run || bench) {
         llvm::SmallString<128> currentPath;
         if (auto error = llvm::sys::fs::current_path(currentPath)) {
             ABORT(error.message());
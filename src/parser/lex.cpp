@@ -257,6 +257,7 @@ static const llvm::StringMap<Token::Kind> keywords = {
     {"struct", Token::Struct},
     {"switch", Token::Switch},
     {"this", Token::This},
+    {"thread_local", Token::ThreadLocal},
     {"true", Token::True},
     {"undefined", Token::Undefined},
     {"var", Token::Var},
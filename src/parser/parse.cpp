@@ -140,6 +140,14 @@ std::vector<NamedValue> Parser::parseArgumentList(bool allowEmpty) {
         }
         auto value = parseExpr();
         if (!location.isValid()) location = value->getLocation();
+
+        if (currentToken() == Token::DotDotDot) {
+            auto* varExpr = llvm::dyn_cast<VarExpr>(value);
+            if (!varExpr) ERROR(currentToken().getLocation(), "only parameter packs can be expanded with '...'");
+            consumeToken();
+            value = new VarExpr(getPackKey(varExpr->getIdentifier()), varExpr->getLocation());
+        }
+
         args.push_back({std::move(name), value, location});
     } while (parse({Token::Comma, Token::RightParen}) == Token::Comma);
 
@@ -509,6 +517,7 @@ LambdaExpr* Parser::parseLambdaExpr() {
         params.push_back(ParamDecl(Type(), paramName.getString().str(), false, paramName.getLocation()));
     } else {
         params = parseParamList(nullptr, false);
+        validateParamPacks(nullptr, params);
     }
 
     parse(Token::RightArrow);
@@ -721,6 +730,11 @@ Expr* Parser::parseBinaryExpr(int minPrecedence) {
             continue;
         }
 
+        // A trailing '...' before ',' or ')' is a parameter pack expansion, handled by parseArgumentList().
+        if (currentToken() == Token::DotDotDot && lookAhead(1).is({Token::Comma, Token::RightParen})) {
+            break;
+        }
+
         auto backtrackLocation = currentTokenIndex;
         auto op = consumeToken();
         auto rhs = parseBinaryExpr(getPrecedence(op) + 1);
@@ -1026,7 +1040,7 @@ std::vector<Stmt*> Parser::parseStmtsUntilOneOf(Token::Kind end1, Token::Kind en
     return stmts;
 }
 
-/// param-decl ::= 'public'? type? id
+/// param-decl ::= 'public'? type? '...'? id
 ParamDecl Parser::parseParam(bool requireType) {
     bool isPublic = currentToken() == Token::Public;
     if (isPublic) consumeToken();
@@ -1036,8 +1050,13 @@ ParamDecl Parser::parseParam(bool requireType) {
         type = parseType();
     }
 
+    bool isPack = type && currentToken() == Token::DotDotDot;
+    if (isPack) consumeToken();
+
     auto name = parse(Token::Identifier);
-    return ParamDecl(type, name.getString().str(), isPublic, name.getLocation());
+    ParamDecl param(type, name.getString().str(), isPublic, name.getLocation());
+    param.isPack = isPack;
+    return param;
 }
 
 /// param-list ::= '(' params ')'
@@ -1059,12 +1078,20 @@ std::vector<ParamDecl> Parser::parseParamList(bool* isVariadic, bool requireType
     return params;
 }
 
+/// generic-param-list ::= '<' generic-param-decls '>'
+/// generic-param-decls ::= generic-param-decl | generic-param-decl ',' generic-param-decls
+/// generic-param-decl ::= id '...'? (':' type)?
 void Parser::parseGenericParamList(std::vector<GenericParamDecl>& genericParams) {
     parse(Token::Less);
     while (true) {
         auto genericParamName = parse(Token::Identifier);
         genericParams.emplace_back(genericParamName.getString().str(), genericParamName.getLocation());
 
+        if (currentToken() == Token::DotDotDot) {
+            consumeToken();
+            genericParams.back().isPack = true;
+        }
+
         if (currentToken() == Token::Colon) {
             consumeToken();
             genericParams.back().constraints = {parseType()};
@@ -1103,6 +1130,35 @@ llvm::StringRef Parser::parseFunctionName(TypeDecl* receiverTypeDecl) {
     }
 }
 
+void Parser::validateParamPacks(const std::vector<GenericParamDecl>* genericParams, llvm::ArrayRef<ParamDecl> params) {
+    const GenericParamDecl* genericPack = nullptr;
+
+    if (genericParams) {
+        for (auto& genericParam : *genericParams) {
+            if (!genericParam.isPack) continue;
+            if (&genericParam != &genericParams->back()) {
+                ERROR(genericParam.getLocation(), "variadic generic parameter must be the last generic parameter");
+            }
+            genericPack = &genericParam;
+        }
+    }
+
+    for (auto& param : params) {
+        if (!param.isPack) continue;
+        if (&param != &params.back()) {
+            ERROR(param.getLocation(), "parameter pack must be the last parameter");
+        }
+        if (!genericPack) {
+            ERROR(param.getLocation(), "parameter pack requires a variadic generic parameter");
+        }
+        return;
+    }
+
+    if (genericPack) {
+        ERROR(genericPack->getLocation(), "variadic generic parameter '" << genericPack->getName() << "' must be used by a parameter pack");
+    }
+}
+
 /// function-proto ::= type id param-list
 FunctionDecl* Parser::parseFunctionProto(bool isExtern, TypeDecl* receiverTypeDecl, AccessLevel accessLevel, std::vector<GenericParamDecl>* genericParams,
                                          Type returnType, llvm::StringRef name, Location location) {
@@ -1112,6 +1168,7 @@ FunctionDecl* Parser::parseFunctionProto(bool isExtern, TypeDecl* receiverTypeDe
 
     bool isVariadic = false;
     auto params = parseParamList(isExtern ? &isVariadic : nullptr);
+    validateParamPacks(genericParams, params);
     FunctionProto proto(name.str(), std::move(params), returnType, isVariadic, isExtern);
 
     if (receiverTypeDecl) {
@@ -1165,6 +1222,7 @@ ConstructorDecl* Parser::parseConstructorDecl(TypeDecl& receiverTypeDecl, Access
     ASSERT(currentToken() == Token::Identifier);
     auto location = consumeToken().getLocation();
     auto params = parseParamList(nullptr);
+    validateParamPacks(nullptr, params);
     auto decl = new ConstructorDecl(receiverTypeDecl, std::move(params), accessLevel, location);
     decl->body = parseBlock(decl);
     return decl;
@@ -1209,6 +1267,12 @@ Token Parser::parseTypeHeader(std::vector<Type>& interfaces, std::vector<Generic
 
     if (currentToken() == Token::Less) {
         parseGenericParamList(*genericParams);
+
+        for (auto& genericParam : *genericParams) {
+            if (genericParam.isPack) {
+                ERROR(genericParam.getLocation(), "variadic generic parameters are only supported on functions");
+            }
+        }
     }
 
     if (currentToken() == Token::Colon) {
@@ -1411,7 +1475,8 @@ void Parser::parseIfdef(std::vector<Decl*>* activeDecls) {
     consumeToken();
 }
 
-/// top-level-decl ::= function-decl | extern-function-decl | type-decl | enum-decl | import-decl | var-decl
+/// top-level-decl ::= function-decl | extern-function-decl | type-decl | enum-decl | import-decl | var-decl | thread-local-var-decl
+/// thread-local-var-decl ::= 'thread_local' var-decl
 /// @throws CompileError
 Decl* Parser::parseTopLevelDecl(bool addToSymbolTable) {
     AccessLevel accessLevel = AccessLevel::Default;
@@ -1453,6 +1518,17 @@ start:
         decl = parseVarDecl(nullptr, accessLevel);
         if (addToSymbolTable) currentModule->addToSymbolTable(llvm::cast<VarDecl>(*decl));
         break;
+    case Token::ThreadLocal: {
+        consumeToken();
+        auto* varDecl = parseVarDecl(nullptr, accessLevel);
+        if (!varDecl->type.isMutable()) {
+            ERROR(varDecl->getLocation(), "thread-local variables must be mutable");
+        }
+        varDecl->isThreadLocal = true;
+        if (addToSymbolTable) currentModule->addToSymbolTable(*varDecl);
+        decl = varDecl;
+        break;
+    }
     case Token::Import:
         if (accessLevel != AccessLevel::Default) {
             WARN(lookAhead(-1).getLocation(), "imports cannot have access specifiers");
@@ -137,6 +137,7 @@ private:
     ParamDecl parseParam(bool requireType);
     std::vector<ParamDecl> parseParamList(bool* isVariadic, bool requireTypes = true);
     void parseGenericParamList(std::vector<GenericParamDecl>& genericParams);
+    void validateParamPacks(const std::vector<GenericParamDecl>* genericParams, llvm::ArrayRef<ParamDecl> params);
     llvm::StringRef parseFunctionName(TypeDecl* receiverTypeDecl);
     FunctionDecl* parseFunctionProto(bool isExtern, TypeDecl* receiverTypeDecl, AccessLevel accessLevel, std::vector<GenericParamDecl>* genericParams,
                                      Type returnType, llvm::StringRef name, Location location);
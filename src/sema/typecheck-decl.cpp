@@ -125,6 +125,9 @@ void Typechecker::typecheckGenericParamDecls(llvm::ArrayRef<GenericParamDecl> ge
         }
 
         for (Type constraint : genericParam.constraints) {
+            // Function type constraints refer to the other generic parameters, so they're checked against the inferred generic arguments.
+            if (constraint.isFunctionType()) continue;
+
             try {
                 typecheckType(constraint, userAccessLevel);
 
@@ -195,7 +198,11 @@ void Typechecker::typecheckFunctionDecl(FunctionDecl& decl) {
                 }
             }
 
-            ASSERT(decl.getReturnType());
+            // A lambda whose body has no return statements returns void.
+            if (!decl.getReturnType()) {
+                ASSERT(decl.isLambda());
+                decl.proto.returnType = Type::getVoid();
+            }
 
             // This prevents creating destructors calls during codegen.
             for (auto* movedDecl : movedDecls) {
@@ -254,6 +261,16 @@ void Typechecker::typecheckTypeDecl(TypeDecl& decl) {
         }
     }
 
+    if (decl.isStructOfArrays()) {
+        auto elementType = decl.genericArgs.front();
+        auto* elementTypeDecl = elementType.getDecl();
+        if (!elementTypeDecl || !elementTypeDecl->isStruct() || !elementTypeDecl->isCopyable()) {
+            auto location = elementType.getLocation().isValid() ? elementType.getLocation() : decl.getLocation();
+            REPORT_ERROR(location, "SoAList element type '" << elementType << "' must be a Copyable struct");
+            return;
+        }
+    }
+
     TypeDecl* realDecl;
 
     if (decl.isInterface()) {
@@ -24,21 +24,51 @@ void Typechecker::checkHasAccess(const Decl& decl, Location location, AccessLeve
     }
 }
 
-void Typechecker::checkLambdaCapture(const VariableDecl& variableDecl, const VarExpr& varExpr) const {
-    auto* parent = getCurrentModule()->getSymbolTable().getCurrentScope().parent;
-    if (parent && parent->isLambda() && variableDecl.parent != parent) {
-        ERROR(varExpr.getLocation(), "lambda capturing not implemented yet");
+/// Adds 'variableDecl' to the captures of each lambda between its declaration and the current scope.
+void Typechecker::recordLambdaCapture(VariableDecl& variableDecl) {
+    if (!currentFunction || !currentFunction->isLambda() || variableDecl.isFieldDecl() || variableDecl.isGlobal()) return;
+
+    auto scopes = getCurrentModule()->getSymbolTable().getScopes();
+    llvm::SmallVector<FunctionDecl*, 4> enclosingLambdas;
+
+    for (size_t i = scopes.size(); i-- > 0;) {
+        auto it = scopes[i]->decls.find(variableDecl.getName());
+
+        if (it != scopes[i]->decls.end() && llvm::is_contained(it->second, &variableDecl)) {
+            // The function that declares the variable doesn't capture it, only the lambdas nested in it do.
+            for (size_t j = i + 1; j-- > 0;) {
+                if (auto* owner = scopes[j]->parent) {
+                    enclosingLambdas.erase(std::remove(enclosingLambdas.begin(), enclosingLambdas.end(), owner), enclosingLambdas.end());
+                    break;
+                }
+            }
+
+            for (auto* lambda : enclosingLambdas) {
+                if (!llvm::is_contained(lambda->captures, &variableDecl)) {
+                    lambda->captures.push_back(&variableDecl);
+                }
+            }
+            return;
+        }
+
+        if (auto* functionDecl = llvm::dyn_cast_or_null<FunctionDecl>(scopes[i]->parent); functionDecl && functionDecl->isLambda()) {
+            enclosingLambdas.push_back(functionDecl);
+        }
     }
 }
 
 Type Typechecker::typecheckVarExpr(VarExpr& expr, bool useIsWriteOnly) {
+    if (expr.getIdentifier().ends_with("...")) {
+        ERROR(expr.getLocation(), "'" << expr.getIdentifier().drop_back(3) << "' is not a parameter pack");
+    }
+
     auto* decl = findDecl(expr.getIdentifier(), expr.getLocation());
     checkHasAccess(*decl, expr.getLocation(), AccessLevel::None);
     decl->referenced = true;
     expr.setDecl(decl);
 
     if (auto variableDecl = llvm::dyn_cast<VariableDecl>(decl)) {
-        checkLambdaCapture(*variableDecl, expr);
+        recordLambdaCapture(*variableDecl);
     }
 
     switch (decl->kind) {
@@ -689,17 +719,82 @@ static Type replaceUnresolvedGenericParamsWithPlaceholders(Type type, llvm::Arra
     return type.resolve(placeholders);
 }
 
+/// Returns the function type of a value that can be called, i.e. a function pointer or a closure, or null otherwise.
+static FunctionType* getCallableFunctionType(Type type) {
+    if (auto* closureFunction = type.getClosureFunction()) {
+        return closureFunction->getFunctionType();
+    }
+    return llvm::dyn_cast<FunctionType>(type.getBase());
+}
+
 std::vector<Type> Typechecker::inferGenericArgsFromCallArgs(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, llvm::ArrayRef<ParamDecl> params,
                                                             bool returnOnError) {
-    if (call.getArgs().size() != params.size()) return {};
+    bool hasParamPack = !params.empty() && params.back().isPack;
+    auto fixedParams = hasParamPack ? params.drop_back() : params;
+
+    if (hasParamPack ? call.getArgs().size() <= fixedParams.size() : call.getArgs().size() != params.size()) return {};
 
     std::vector<Type> inferredGenericArgs;
 
+    // Arguments to a parameter whose type is a generic parameter with a function type constraint, e.g. 'F transform' with
+    // 'F: Output(Element*)', are typechecked first. Lambdas passed to such parameters get their own closure type, so
+    // that each lambda gets its own instantiation of the callee, in which it can be called directly and inlined.
+    llvm::StringMap<Type> callableGenericArgs;
+
     for (auto& genericParam : genericParams) {
+        if (genericParam.isPack || genericParam.constraints.empty() || !genericParam.constraints[0].isFunctionType()) continue;
+
+        for (auto&& [param, arg] : llvm::zip_first(fixedParams, call.getArgs())) {
+            if (!param.type.isBasicType() || param.type.getName() != genericParam.getName() || !param.type.getGenericArgs().empty()) continue;
+
+            auto* argValue = arg.getValue();
+            auto expectedType = replaceUnresolvedGenericParamsWithPlaceholders(genericParam.constraints[0], genericParams);
+            Type argType;
+
+            if (argValue->hasType()) {
+                argType = argValue->getType();
+            } else if (auto* lambdaExpr = llvm::dyn_cast<LambdaExpr>(argValue)) {
+                argType = typecheckLambdaExpr(*lambdaExpr, expectedType, true);
+                lambdaExpr->setType(argType);
+                lambdaExpr->setAssignableType(argType);
+            } else {
+                argType = typecheckExpr(*argValue, false, expectedType);
+            }
+
+            if (!getCallableFunctionType(argType)) return {};
+            callableGenericArgs.try_emplace(genericParam.getName(), argType);
+            break;
+        }
+    }
+
+    for (auto& genericParam : genericParams) {
+        if (auto it = callableGenericArgs.find(genericParam.getName()); it != callableGenericArgs.end()) {
+            inferredGenericArgs.push_back(it->second);
+            continue;
+        }
+
+        if (genericParam.isPack) {
+            // Infer one element type for each argument passed to the parameter pack.
+            auto& packParam = params.back();
+            auto expectedType = replaceUnresolvedGenericParamsWithPlaceholders(packParam.type, genericParams);
+            std::vector<TupleElement> elements;
+
+            for (auto& arg : call.getArgs().drop_front(fixedParams.size())) {
+                auto* argValue = arg.getValue();
+                Type argType = argValue->hasType() ? argValue->getType() : typecheckExpr(*argValue, false, expectedType);
+                Type element = findGenericArg(argType, packParam.type, genericParam.getName());
+                if (!element) return {};
+                elements.push_back({"", element});
+            }
+
+            inferredGenericArgs.push_back(TupleType::get(std::move(elements)));
+            continue;
+        }
+
         Type genericArg;
         Expr* genericArgValue = nullptr;
 
-        for (auto&& [param, arg] : llvm::zip_first(params, call.getArgs())) {
+        for (auto&& [param, arg] : llvm::zip_first(fixedParams, call.getArgs())) {
             Type paramType = param.type;
 
             if (containsGenericParam(paramType, genericParam.getName())) {
@@ -730,6 +825,17 @@ std::vector<Type> Typechecker::inferGenericArgsFromCallArgs(llvm::ArrayRef<Gener
             }
         }
 
+        if (!genericArg) {
+            // Generic parameters that only appear in a function type constraint are inferred from the argument's signature.
+            for (auto& callableGenericParam : genericParams) {
+                auto it = callableGenericArgs.find(callableGenericParam.getName());
+                if (it == callableGenericArgs.end()) continue;
+
+                Type functionType(getCallableFunctionType(it->second), Mutability::Mutable, Location());
+                if ((genericArg = findGenericArg(functionType, callableGenericParam.constraints[0], genericParam.getName()))) break;
+            }
+        }
+
         if (genericArg) {
             inferredGenericArgs.push_back(genericArg);
         } else {
@@ -738,23 +844,47 @@ std::vector<Type> Typechecker::inferGenericArgsFromCallArgs(llvm::ArrayRef<Gener
     }
 
     ASSERT(genericParams.size() == inferredGenericArgs.size());
+    llvm::StringMap<Type> genericArgsByName;
+
+    for (auto&& [genericParam, genericArg] : llvm::zip(genericParams, inferredGenericArgs)) {
+        genericArgsByName.try_emplace(genericParam.getName(), genericArg);
+    }
 
     for (auto&& [genericParam, genericArg] : llvm::zip(genericParams, inferredGenericArgs)) {
         if (!genericParam.constraints.empty()) {
             ASSERT(genericParam.constraints.size() == 1, "cannot have multiple generic constraints yet");
-            auto* interface = getTypeDecl(*llvm::cast<BasicType>(genericParam.constraints[0].getBase()));
 
-            if (auto basicType = llvm::dyn_cast<BasicType>(genericArg.getBase())) {
-                auto* typeDecl = getTypeDecl(*basicType);
-                if (typeDecl && typeDecl->hasInterface(*interface)) {
+            if (genericParam.constraints[0].isFunctionType()) {
+                Type constraint = genericParam.constraints[0].resolve(genericArgsByName);
+                auto* functionType = getCallableFunctionType(genericArg);
+
+                if (functionType && isImplicitlyConvertible(nullptr, Type(functionType, Mutability::Mutable, Location()), constraint)) {
                     continue;
                 }
+
+                if (returnOnError) {
+                    return {};
+                } else {
+                    ERROR(call.getLocation(), "type '" << genericArg << "' is not callable as '" << constraint << "'");
+                }
             }
 
-            if (returnOnError) {
-                return {};
-            } else {
-                ERROR(call.getLocation(), "type '" << genericArg << "' doesn't implement interface '" << interface->getName() << "'");
+            auto* interface = getTypeDecl(*llvm::cast<BasicType>(genericParam.constraints[0].getBase()));
+            auto types = genericParam.isPack ? map(genericArg.getTupleElements(), [](auto& element) { return element.type; }) : std::vector<Type>{genericArg};
+
+            for (Type type : types) {
+                if (auto basicType = llvm::dyn_cast<BasicType>(type.getBase())) {
+                    auto* typeDecl = getTypeDecl(*basicType);
+                    if (typeDecl && typeDecl->hasInterface(*interface)) {
+                        continue;
+                    }
+                }
+
+                if (returnOnError) {
+                    return {};
+                } else {
+                    ERROR(call.getLocation(), "type '" << type << "' doesn't implement interface '" << interface->getName() << "'");
+                }
             }
         }
     }
@@ -770,14 +900,55 @@ void cx::validateGenericArgCount(size_t genericParamCount, llvm::ArrayRef<Type>
     }
 }
 
+/// Builds the key under which the generic arguments inferred for a call are cached. Returns false if the inferred arguments
+/// can depend on more than the types of the arguments, e.g. on the value of an integer constant.
+static bool getGenericArgsCacheKey(const CallExpr& call, const FunctionDecl* decl, Type expectedType, bool returnOnError, std::string& key) {
+    if (!call.getGenericArgs().empty()) return false;
+
+    auto append = [&](const void* pointer, unsigned flags) {
+        key.append(reinterpret_cast<const char*>(&pointer), sizeof(pointer));
+        key.push_back(char(flags));
+    };
+
+    append(decl, returnOnError);
+    append(expectedType.getBase(), expectedType && expectedType.isMutable());
+
+    for (auto& arg : call.getArgs()) {
+        auto* value = arg.getValue();
+        if (!value->hasType() || value->isIfExpr() || value->isArrayLiteralExpr()) return false;
+
+        Type type = value->getType();
+        if (value->isConstant() && (type.isInteger() || type.isChar() || type.isEnumType() || type.isFloatingPoint())) return false;
+
+        append(type.getBase(), type.isMutable() | value->isLvalue() << 1 | value->isStringLiteralExpr() << 2 | value->isNullLiteralExpr() << 3);
+    }
+
+    return true;
+}
+
 llvm::StringMap<Type> Typechecker::getGenericArgsForCall(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, FunctionDecl* decl, bool returnOnError,
                                                          Type expectedType) {
+    std::string cacheKey;
+    if (!getGenericArgsCacheKey(call, decl, expectedType, returnOnError, cacheKey)) {
+        return inferGenericArgsForCall(genericParams, call, decl, returnOnError, expectedType);
+    }
+
+    auto it = genericArgsCache.find(cacheKey);
+    if (it != genericArgsCache.end()) return it->second;
+
+    auto genericArgs = inferGenericArgsForCall(genericParams, call, decl, returnOnError, expectedType);
+    genericArgsCache.try_emplace(cacheKey, genericArgs);
+    return genericArgs;
+}
+
+llvm::StringMap<Type> Typechecker::inferGenericArgsForCall(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, FunctionDecl* decl, bool returnOnError,
+                                                           Type expectedType) {
     ASSERT(!genericParams.empty());
     std::vector<Type> inferredGenericArgs;
     llvm::ArrayRef<Type> genericArgTypes;
 
     if (call.getGenericArgs().empty()) {
-        if (expectedType && expectedType.isBasicType() && !expectedType.getGenericArgs().empty()
+        if (!genericParams.back().isPack && expectedType && expectedType.isBasicType() && expectedType.getGenericArgs().size() == genericParams.size()
             && llvm::none_of(expectedType.getGenericArgs(), [](Type t) { return t.isUnresolvedType(); })
             && BasicType::get(expectedType.getName(), {}).getDecl() == (decl->isConstructorDecl() ? decl->getTypeDecl() : decl->getReturnType().getDecl())) {
             genericArgTypes = expectedType.getGenericArgs();
@@ -792,13 +963,21 @@ llvm::StringMap<Type> Typechecker::getGenericArgsForCall(llvm::ArrayRef<GenericP
         }
     } else {
         genericArgTypes = call.getGenericArgs();
+
+        if (genericParams.back().isPack) {
+            // Collect the trailing explicit generic arguments into the variadic generic parameter.
+            inferredGenericArgs.assign(genericArgTypes.begin(), genericArgTypes.begin() + genericParams.size() - 1);
+            auto packElements = map(genericArgTypes.drop_front(genericParams.size() - 1), [](Type type) { return TupleElement{"", type}; });
+            inferredGenericArgs.push_back(TupleType::get(std::move(packElements)));
+            genericArgTypes = inferredGenericArgs;
+        }
     }
 
     llvm::StringMap<Type> genericArgs;
     auto genericArg = genericArgTypes.begin();
 
     for (const GenericParamDecl& genericParam : genericParams) {
-        genericArgs.try_emplace(genericParam.getName(), *genericArg++);
+        genericArgs.try_emplace(genericParam.isPack ? getPackKey(genericParam.getName()) : genericParam.getName().str(), *genericArg++);
     }
 
     return genericArgs;
@@ -835,7 +1014,8 @@ static std::vector<Note> getCandidateNotes(llvm::ArrayRef<Decl*> unfilteredCandi
             functionDecl = functionTemplate ? functionTemplate->functionDecl : nullptr;
         }
 
-        if (!functionDecl || functionDecl->getParams().size() == expr.getArgs().size()) {
+        if (!functionDecl || functionDecl->getParams().size() == expr.getArgs().size()
+            || (!functionDecl->getParams().empty() && functionDecl->getParams().back().isPack && functionDecl->getParams().size() <= expr.getArgs().size())) {
             candidates.push_back(candidate);
         }
     }
@@ -857,7 +1037,7 @@ static const Match* findMatchByPredicate(llvm::ArrayRef<Match> matches, const Ca
         if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(match.decl)) {
             params = functionDecl->getParams();
         } else if (auto variableDecl = llvm::dyn_cast<VariableDecl>(match.decl)) {
-            params = llvm::cast<FunctionType>(variableDecl->type.getBase())->getParamDecls();
+            params = getCallableFunctionType(variableDecl->type)->getParamDecls();
         } else {
             llvm_unreachable("unhandled callee decl");
         }
@@ -912,6 +1092,26 @@ static bool equals(const llvm::StringMap<Type>& a, const llvm::StringMap<Type>&
     return true;
 }
 
+/// Returns false if the number or names of the call's arguments can't match the parameters of the function template, so
+/// that its generic arguments don't need to be inferred and instantiated to find that out.
+static bool mayMatchArguments(const CallExpr& expr, const FunctionTemplate& functionTemplate) {
+    auto* functionDecl = functionTemplate.functionDecl;
+    auto params = functionDecl->getParams();
+    bool hasParamPack = !params.empty() && params.back().isPack;
+    auto fixedParams = hasParamPack ? params.drop_back() : params;
+    auto args = expr.getArgs();
+
+    if (hasParamPack || functionDecl->isVariadic() ? args.size() < fixedParams.size() : args.size() != params.size()) {
+        return false;
+    }
+
+    for (auto&& [param, arg] : llvm::zip_first(fixedParams, args)) {
+        if (!arg.getName().empty() && arg.getName() != param.getName()) return false;
+    }
+
+    return true;
+}
+
 Decl* Typechecker::resolveOverload(llvm::ArrayRef<Decl*> decls, CallExpr& expr, llvm::StringRef callee, Type expectedType) {
     std::vector<Match> matches;
     std::vector<Match> templateMatches;
@@ -925,13 +1125,17 @@ Decl* Typechecker::resolveOverload(llvm::ArrayRef<Decl*> decls, CallExpr& expr,
             auto* functionTemplate = llvm::cast<FunctionTemplate>(decl);
             auto genericParams = functionTemplate->genericParams;
 
-            if (!expr.getGenericArgs().empty() && expr.getGenericArgs().size() != genericParams.size()) {
+            bool isVariadic = genericParams.back().isPack;
+
+            if (!expr.getGenericArgs().empty() && (isVariadic ? expr.getGenericArgs().size() < genericParams.size() : expr.getGenericArgs().size() != genericParams.size())) {
                 if (decls.size() == 1) {
                     validateGenericArgCount(genericParams.size(), expr.getGenericArgs(), expr.getFunctionName(), expr.getLocation());
                 }
                 continue;
             }
 
+            if (decls.size() != 1 && !mayMatchArguments(expr, *functionTemplate)) continue;
+
             auto genericArgs = getGenericArgsForCall(genericParams, expr, functionTemplate->functionDecl, decls.size() != 1, expectedType);
             if (genericArgs.empty()) continue; // Couldn't infer generic arguments.
 
@@ -1035,7 +1239,7 @@ Decl* Typechecker::resolveOverload(llvm::ArrayRef<Decl*> decls, CallExpr& expr,
         case DeclKind::FieldDecl: {
             auto* variableDecl = llvm::cast<VariableDecl>(decl);
 
-            if (auto* functionType = llvm::dyn_cast<FunctionType>(variableDecl->type.getBase())) {
+            if (auto* functionType = getCallableFunctionType(variableDecl->type)) {
                 auto paramDecls = functionType->getParamDecls(variableDecl->getLocation());
 
                 if (decls.size() == 1) {
@@ -1130,6 +1334,14 @@ Type Typechecker::typecheckCallExpr(CallExpr& expr, Type expectedType) {
         return typecheckBuiltinCast(expr);
     }
 
+    if (expr.isBuiltinAtomic()) {
+        return typecheckBuiltinAtomic(expr);
+    }
+
+    if (expr.isBuiltinTypeTrait()) {
+        return typecheckBuiltinTypeTrait(expr);
+    }
+
     if (expr.getFunctionName() == "assert") {
         ParamDecl assertParam(Type::getBool(), "", false, Location());
         validateAndConvertArguments(expr, assertParam, false, expr.getFunctionName(), expr.getLocation());
@@ -1197,6 +1409,7 @@ Type Typechecker::typecheckCallExpr(CallExpr& expr, Type expectedType) {
             expr.setReceiverType(constructorDecl->getTypeDecl()->getType());
         } else if (decl->isMethodDecl()) {
             auto* varDecl = llvm::cast<VarDecl>(findDecl("this", expr.getCallee().getLocation()));
+            recordLambdaCapture(*varDecl);
             expr.setReceiverType(varDecl->type);
         }
     }
@@ -1211,7 +1424,7 @@ Type Typechecker::typecheckCallExpr(CallExpr& expr, Type expectedType) {
     if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(decl)) {
         params = functionDecl->getParams();
     } else if (auto variableDecl = llvm::dyn_cast<VariableDecl>(decl)) {
-        params = llvm::cast<FunctionType>(variableDecl->type.getBase())->getParamDecls();
+        params = getCallableFunctionType(variableDecl->type)->getParamDecls();
     } else {
         auto type = llvm::cast<EnumCase>(decl)->associatedType;
         params = map(type.getTupleElements(), [&](auto& e) { return ParamDecl(e.type, std::string(e.name), false, decl->getLocation()); });
@@ -1227,6 +1440,10 @@ Type Typechecker::typecheckCallExpr(CallExpr& expr, Type expectedType) {
     expr.setCalleeDecl(decl);
     decl->referenced = true;
 
+    if (auto* variableDecl = llvm::dyn_cast<VariableDecl>(decl)) {
+        recordLambdaCapture(*variableDecl);
+    }
+
     if (auto constructorDecl = llvm::dyn_cast<ConstructorDecl>(decl)) {
         if (constructorDecl->getTypeDecl()->isInterface()) {
             typecheckFunctionDecl(*constructorDecl);
@@ -1235,7 +1452,7 @@ Type Typechecker::typecheckCallExpr(CallExpr& expr, Type expectedType) {
     } else if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(decl)) {
         return functionDecl->getFunctionType()->getReturnType();
     } else if (auto variableDecl = llvm::dyn_cast<VariableDecl>(decl)) {
-        return llvm::cast<FunctionType>(variableDecl->type.getBase())->getReturnType();
+        return getCallableFunctionType(variableDecl->type)->getReturnType();
     } else {
         return llvm::cast<EnumCase>(decl)->type;
     }
@@ -1296,7 +1513,7 @@ void Typechecker::validateAndConvertArguments(CallExpr& expr, const Decl& callee
     if (auto functionDecl = llvm::dyn_cast<FunctionDecl>(&calleeDecl)) {
         validateAndConvertArguments(expr, functionDecl->getParams(), functionDecl->isVariadic(), functionName, location);
     } else {
-        auto functionType = llvm::cast<FunctionType>(llvm::cast<VariableDecl>(calleeDecl).type.getBase());
+        auto functionType = getCallableFunctionType(llvm::cast<VariableDecl>(calleeDecl).type);
         auto paramDecls = functionType->getParamDecls(calleeDecl.getLocation());
         validateAndConvertArguments(expr, paramDecls, false, functionName, location);
     }
@@ -1389,6 +1606,8 @@ static bool isValidCast(Type sourceType, Type targetType) {
             } else if (sourcePointee == targetType.getElementType()) {
                 return true;
             }
+        } else if (targetType.isInteger()) {
+            return true;
         }
 
         return false;
@@ -1426,6 +1645,53 @@ Type Typechecker::typecheckBuiltinCast(CallExpr& expr) {
     return targetType;
 }
 
+Type Typechecker::typecheckBuiltinAtomic(CallExpr& expr) {
+    auto functionName = expr.getFunctionName();
+    validateGenericArgCount(0, expr.getGenericArgs(), functionName, expr.getLocation());
+
+    if (expr.getArgs().empty()) {
+        ERROR(expr.getLocation(), "too few arguments to '" << functionName << "', expected a pointer to the atomic value");
+    }
+
+    Type pointerType = typecheckExpr(*expr.getArgs().front().getValue());
+    if (!pointerType.isPointerType()) {
+        ERROR(expr.getArgs().front().getLocation(), "first argument to '" << functionName << "' must be a pointer, found '" << pointerType << "'");
+    }
+
+    Type valueType = pointerType.getPointee();
+    bool isArithmetic = functionName.starts_with("atomicFetch");
+
+    if (!valueType.isInteger() && (isArithmetic || !valueType.removeOptional().isPointerType())) {
+        ERROR(expr.getArgs().front().getLocation(), "'" << functionName << "' is not supported for type '" << valueType << "', expected "
+                                                        << (isArithmetic ? "an integer" : "an integer or a pointer"));
+    }
+
+    if (functionName != "atomicLoad" && !valueType.isMutable()) {
+        ERROR(expr.getArgs().front().getLocation(), "cannot modify immutable value of type '" << valueType << "'");
+    }
+
+    std::vector<ParamDecl> params;
+    params.emplace_back(pointerType, "", false, expr.getLocation());
+    if (functionName != "atomicLoad") params.emplace_back(valueType, "", false, expr.getLocation());
+    if (functionName == "atomicCompareExchange") params.emplace_back(valueType, "", false, expr.getLocation());
+    validateAndConvertArguments(expr, params, false, functionName, expr.getLocation());
+
+    if (functionName == "atomicStore") return Type::getVoid();
+    if (functionName == "atomicCompareExchange") return Type::getBool();
+    return valueType.withMutability(Mutability::Mutable);
+}
+
+/// Typechecks a compile-time query about a type, e.g. 'isTriviallyRelocatable<T>()'. The value is
+/// computed during IR generation, when the generic arguments have been resolved.
+Type Typechecker::typecheckBuiltinTypeTrait(CallExpr& expr) {
+    validateGenericArgCount(1, expr.getGenericArgs(), expr.getFunctionName(), expr.getLocation());
+    validateAndConvertArguments(expr, {}, false, expr.getFunctionName(), expr.getLocation());
+    if (!expr.getGenericArgs().empty()) {
+        typecheckType(expr.getGenericArgs().front(), AccessLevel::None);
+    }
+    return Type::getBool();
+}
+
 Type Typechecker::typecheckSizeofExpr(SizeofExpr& expr) {
     typecheckType(expr.getOperandType(), AccessLevel::None);
     return Type::getUInt64();
@@ -1453,7 +1719,19 @@ Type Typechecker::typecheckMemberExpr(MemberExpr& expr) {
             }
         }
     } else {
-        for (auto& field : baseType.getDecl()->fields) {
+        auto* typeDecl = baseType.getDecl();
+
+        // Fields of a SoAList element are accessed through the element's entry in the list's column for the field.
+        if (typeDecl->isStructOfArraysElement() && !expr.getBaseExpr()->isThis()) {
+            auto* elementTypeDecl = typeDecl->genericArgs.front().getDecl();
+            if (auto* field = elementTypeDecl ? elementTypeDecl->getField(expr.getMemberName()) : nullptr) {
+                checkHasAccess(*field, expr.getLocation(), AccessLevel::None);
+                expr.setDecl(*field);
+                return field->type.withMutability(baseType.getMutability());
+            }
+        }
+
+        for (auto& field : typeDecl->fields) {
             if (field.getName() == expr.getMemberName()) {
                 checkHasAccess(field, expr.getLocation(), AccessLevel::None);
                 expr.setDecl(field);
@@ -1528,9 +1806,13 @@ Type Typechecker::typecheckUnwrapExpr(UnwrapExpr& expr) {
     return type.getWrappedType();
 }
 
-Type Typechecker::typecheckLambdaExpr(LambdaExpr& expr, Type expectedType) {
-    for (size_t i = 0, e = expr.getFunctionDecl()->getParams().size(); i < e; ++i) {
-        auto& param = expr.getFunctionDecl()->getParams()[i];
+/// Lambdas that capture variables, or that are passed to a closure parameter, get a unique closure type. Non-capturing
+/// lambdas elsewhere have a plain function type so that they can be passed as function pointers.
+Type Typechecker::typecheckLambdaExpr(LambdaExpr& expr, Type expectedType, bool asClosure) {
+    auto* functionDecl = expr.getFunctionDecl();
+
+    for (size_t i = 0, e = functionDecl->getParams().size(); i < e; ++i) {
+        auto& param = functionDecl->getParams()[i];
         if (!param.type) {
             auto inferredType = expectedType ? expectedType.getParamTypes()[i] : Type();
             if (!inferredType) {
@@ -1540,8 +1822,38 @@ Type Typechecker::typecheckLambdaExpr(LambdaExpr& expr, Type expectedType) {
         }
     }
 
-    typecheckFunctionDecl(*expr.getFunctionDecl());
-    return Type(expr.getFunctionDecl()->getFunctionType(), Mutability::Mutable, expr.getLocation());
+    typecheckFunctionDecl(*functionDecl);
+
+    if (!asClosure && functionDecl->captures.empty()) {
+        return Type(functionDecl->getFunctionType(), Mutability::Mutable, expr.getLocation());
+    }
+
+    if (!asClosure && expectedType && expectedType.isFunctionType()) {
+        ERROR(expr.getLocation(), "lambda capturing '" << functionDecl->captures.front()->getName() << "' cannot be converted to function pointer type '"
+                                                       << expectedType << "'");
+    }
+
+    return getClosureType(*functionDecl)->getType().withLocation(expr.getLocation());
+}
+
+/// Returns the struct type that holds the addresses of the variables captured by 'lambda'.
+TypeDecl* Typechecker::getClosureType(FunctionDecl& lambda) {
+    if (lambda.closureType) return lambda.closureType;
+
+    auto name = "__closure" + lambda.getName().drop_front(strlen("__lambda")).str();
+    std::vector<Type> interfaces = {BasicType::get("Copyable", {})};
+    auto* typeDecl = new TypeDecl(TypeTag::Struct, std::move(name), {}, std::move(interfaces), AccessLevel::Default, *lambda.getModule(), nullptr,
+                                  lambda.getLocation());
+
+    for (auto* capture : lambda.captures) {
+        Type type = capture->type.getPointerTo();
+        typeDecl->addField(FieldDecl(type, capture->getName().str(), nullptr, *typeDecl, AccessLevel::Default, capture->getLocation()));
+    }
+
+    typeDecl->closureFunction = &lambda;
+    llvm::cast<BasicType>(typeDecl->getType().getBase())->setDecl(typeDecl);
+    lambda.closureType = typeDecl;
+    return typeDecl;
 }
 
 Type Typechecker::typecheckIfExpr(IfExpr& expr) {
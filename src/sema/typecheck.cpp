@@ -284,55 +284,61 @@ Decl* Typechecker::findDecl(llvm::StringRef name, Location location) const {
     ERROR(location, "unknown identifier '" << name << "'");
 }
 
-static void appendUnique(std::vector<Decl*>& target, llvm::ArrayRef<Decl*> source) {
+static void appendUnique(std::vector<Decl*>& target, llvm::SmallPtrSetImpl<Decl*>& targetSet, llvm::ArrayRef<Decl*> source) {
     for (auto& element : source) {
         // TODO: Should this ever be false? I.e. should the same decl ever be in multiple different modules?
-        if (!llvm::is_contained(target, element)) {
+        if (targetSet.insert(element).second) {
             target.push_back(element);
         }
     }
 }
 
+llvm::ArrayRef<Decl*> Typechecker::findDeclsInImportedModules(Identifier name) const {
+    auto* stdlibModule = Module::getStdlibModule();
+    auto importedModules = currentSourceFile->getImportedModules();
+    uint64_t generation = stdlibModule->symbolTable.getGlobalGeneration();
+    bool cacheable = stdlibModule->symbolTable.getScopes().size() == 1;
+
+    for (auto* module : importedModules) {
+        generation += module->symbolTable.getGlobalGeneration();
+        cacheable &= module->symbolTable.getScopes().size() == 1;
+    }
+
+    auto& lookup = importedDeclCache[{currentSourceFile, name}];
+    if (cacheable && lookup.generation == generation && generation != 0) {
+        return lookup.decls;
+    }
+
+    lookup.generation = cacheable ? generation : 0;
+    lookup.decls = findDeclsInModules(name.str(), stdlibModule);
+    llvm::append_range(lookup.decls, findDeclsInModules(name.str(), importedModules));
+    return lookup.decls;
+}
+
 std::vector<Decl*> Typechecker::findDecls(llvm::StringRef name, TypeDecl* receiverTypeDecl, bool inAllImportedModules) const {
     ASSERT(!name.empty());
     std::vector<Decl*> decls;
+    llvm::SmallPtrSet<Decl*, 8> declSet;
+    auto identifier = Identifier::get(name);
 
     if (!receiverTypeDecl && currentFunction) {
         receiverTypeDecl = currentFunction->getTypeDecl();
     }
 
     if (receiverTypeDecl) {
-        for (auto& decl : receiverTypeDecl->methods) {
-            if (auto* functionDecl = llvm::dyn_cast<FunctionDecl>(decl)) {
-                if (functionDecl->getName() == name) {
-                    decls.emplace_back(decl);
-                }
-            } else if (auto* functionTemplate = llvm::dyn_cast<FunctionTemplate>(decl)) {
-                if (functionTemplate->getQualifiedName() == name) {
-                    decls.emplace_back(decl);
-                }
-            }
-        }
-
-        for (auto& field : receiverTypeDecl->fields) {
-            // TODO: Only one comparison should be needed.
-            if (field.getName() == name || field.getQualifiedName() == name) {
-                decls.emplace_back(&field);
-            }
-        }
+        appendUnique(decls, declSet, receiverTypeDecl->findMembers(identifier));
     }
 
     if (currentModule->getName() != "std") {
-        appendUnique(decls, findDeclsInModules(name, currentModule, false));
-        appendUnique(decls, findDeclsInModules(name, currentModule, true)); // HACK, TODO: one find function should be enough
+        appendUnique(decls, declSet, findDeclsInModules(name, currentModule, false));
+        appendUnique(decls, declSet, findDeclsInModules(name, currentModule, true)); // HACK, TODO: one find function should be enough
     }
 
-    appendUnique(decls, findDeclsInModules(name, Module::getStdlibModule()));
-
     if (currentSourceFile && !inAllImportedModules) {
-        appendUnique(decls, findDeclsInModules(name, currentSourceFile->getImportedModules()));
+        appendUnique(decls, declSet, findDeclsInImportedModules(identifier));
     } else {
-        appendUnique(decls, findDeclsInModules(name, Module::getAllImportedModules()));
+        appendUnique(decls, declSet, findDeclsInModules(name, Module::getStdlibModule()));
+        appendUnique(decls, declSet, findDeclsInModules(name, Module::getAllImportedModules()));
     }
 
     return decls;
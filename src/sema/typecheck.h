@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #pragma warning(push, 0)
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/ADT/StringMap.h>
 #include <llvm/Support/ErrorOr.h>
@@ -90,12 +91,15 @@ struct Typechecker {
     Type typecheckCallExpr(CallExpr& expr, Type expectedType = Type());
     Type typecheckBuiltinConversion(CallExpr& expr);
     Type typecheckBuiltinCast(CallExpr& expr);
+    Type typecheckBuiltinAtomic(CallExpr& expr);
+    Type typecheckBuiltinTypeTrait(CallExpr& expr);
     Type typecheckSizeofExpr(SizeofExpr& expr);
     Type typecheckMemberExpr(MemberExpr& expr);
     Type typecheckIndexExpr(IndexExpr& expr);
     Type typecheckIndexAssignmentExpr(IndexAssignmentExpr& expr);
     Type typecheckUnwrapExpr(UnwrapExpr& expr);
-    Type typecheckLambdaExpr(LambdaExpr& expr, Type expectedType);
+    Type typecheckLambdaExpr(LambdaExpr& expr, Type expectedType, bool asClosure = false);
+    TypeDecl* getClosureType(FunctionDecl& lambda);
     Type typecheckIfExpr(IfExpr& expr);
 
     bool hasMethod(TypeDecl& type, FunctionDecl& functionDecl) const;
@@ -109,8 +113,11 @@ struct Typechecker {
     Type findGenericArg(Type argType, Type paramType, llvm::StringRef genericParam);
     llvm::StringMap<Type> getGenericArgsForCall(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, FunctionDecl* decl, bool returnOnError,
                                                 Type expectedType);
+    llvm::StringMap<Type> inferGenericArgsForCall(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, FunctionDecl* decl, bool returnOnError,
+                                                  Type expectedType);
     Decl* findDecl(llvm::StringRef name, Location location) const;
     std::vector<Decl*> findDecls(llvm::StringRef name, TypeDecl* receiverTypeDecl = nullptr, bool inAllImportedModules = false) const;
+    llvm::ArrayRef<Decl*> findDeclsInImportedModules(Identifier name) const;
     std::vector<Decl*> findCalleeCandidates(const CallExpr& expr, llvm::StringRef callee);
     Decl* resolveOverload(llvm::ArrayRef<Decl*> decls, CallExpr& expr, llvm::StringRef callee, Type expectedType);
     std::vector<Type> inferGenericArgsFromCallArgs(llvm::ArrayRef<GenericParamDecl> genericParams, CallExpr& call, llvm::ArrayRef<ParamDecl> params,
@@ -124,7 +131,7 @@ struct Typechecker {
     EnumCase* getEnumCase(const Expr& expr);
     void checkReturnPointerToLocal(const Expr* returnValue) const;
     static void checkHasAccess(const Decl& decl, Location location, AccessLevel userAccessLevel);
-    void checkLambdaCapture(const VariableDecl& variableDecl, const VarExpr& varExpr) const;
+    void recordLambdaCapture(VariableDecl& variableDecl);
     llvm::ErrorOr<const Module&> importModule(SourceFile* importer, const PackageManifest* manifest, llvm::StringRef moduleName);
     void deferTypechecking(Decl* decl);
     void postProcess();
@@ -142,6 +149,18 @@ struct Typechecker {
     bool isPostProcessing;
     std::vector<Decl*> declsToTypecheck;
     const CompileOptions& options;
+
+    struct ImportedDeclLookup {
+        uint64_t generation;
+        llvm::SmallVector<Decl*, 4> decls;
+    };
+    /// Results of looking up names in the stdlib and the modules imported by a source file. Entries are reused while the
+    /// global scopes of those modules are unchanged.
+    mutable llvm::DenseMap<std::pair<const SourceFile*, Identifier>, ImportedDeclLookup> importedDeclCache;
+    /// Generic arguments inferred for calls to function templates and constructors of type templates, keyed by the callee
+    /// and the types of the arguments and the expected type. Calls whose arguments haven't been typechecked yet, or whose
+    /// inference depends on argument values, bypass the cache.
+    llvm::StringMap<llvm::StringMap<Type>> genericArgsCache;
 };
 
 void validateGenericArgCount(size_t genericParamCount, llvm::ArrayRef<Type> genericArgs, llvm::StringRef name, Location location);